@@ -0,0 +1,105 @@
+#ifndef H_ANYTIME
+#define H_ANYTIME
+
+#include "vector2.h"
+#include "mesh.h"
+#include "delaunaydc.h"
+#include "steiner.h"
+#include "mst.h"
+#include "greedy.h"
+#include "exact.h"
+#include "profile.h"
+#include "solution.h"
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+
+// Solver with a wall-clock deadline. The MST of the terminals is the
+// baseline; while time is left it is improved with the Fermat points of the
+// Delaunay triangles: greedy insertion first, then (for small candidate
+// sets) the exact branch-and-bound search. A search that runs out of time
+// returns the best tree it has; only the O(n log n) stages before it (MST,
+// triangulation, candidates) cannot be interrupted.
+template <class T>
+class AnytimeSteiner
+{
+public:
+	using VertexType = Vector2<T>;
+	using Clock = std::chrono::steady_clock;
+
+	// Largest candidate set searched exactly (at most 64)
+	void setExactLimit(std::size_t limit) { _exactLimit = std::min(limit, ExactSteiner<T>::maxCandidates); }
+
+	SteinerSolution<T> solve(const std::vector<VertexType> &terminals, Clock::duration budget)
+	{
+		return solve(terminals, Clock::now() + budget);
+	}
+
+	SteinerSolution<T> solve(const std::vector<VertexType> &terminals, Clock::time_point deadline)
+	{
+		PROFILE_SCOPE("AnytimeSteiner::solve");
+		const Clock::time_point start = Clock::now();
+		SteinerSolution<T> result;
+
+		// Baseline
+		result.points = terminals;
+		result.length = _mst.build(terminals);
+		result.tree = _mst.getTree();
+		result.optimal = terminals.size() < 3;
+
+		if (!result.optimal && Clock::now() < deadline)
+		{
+			std::vector<VertexType> candidates = _steiner.additionalVertices(_delaunay.triangulate(terminals.data(), terminals.size()));
+			if (candidates.empty()) result.optimal = true;
+
+			if (!candidates.empty() && Clock::now() < deadline)
+			{
+				_greedy.setDeadline(deadline);
+				float length = _greedy.solve(terminals, candidates);
+				if (length < result.length)
+				{
+					result.points = _greedy.getPoints();
+					result.tree = _greedy.getTree();
+					result.length = length;
+				}
+
+				if (candidates.size() <= _exactLimit && !_greedy.timedOut() && Clock::now() < deadline)
+				{
+					uint64_t initial = 0;
+					for (auto c = begin(_greedy.getChosen()); c != end(_greedy.getChosen()); c++)
+						initial |= (uint64_t)1 << *c;
+
+					_exact.setDeadline(deadline);
+					uint64_t best = _exact.solve(terminals, candidates, initial);
+
+					std::vector<VertexType> points(begin(terminals), end(terminals));
+					for (std::size_t j = 0; j < candidates.size(); j++)
+						if (best >> j & 1) points.push_back(candidates[j]);
+
+					length = _mst.build(points);
+					if (length <= result.length)
+					{
+						result.points = points;
+						result.tree = _mst.getTree();
+						result.length = length;
+					}
+					result.optimal = _exact.isComplete();
+				}
+			}
+		}
+
+		result.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		return result;
+	}
+
+private:
+	DelaunayDC<T> _delaunay;
+	Steiner<T> _steiner;
+	EuclideanMST<T> _mst;
+	GreedySteiner<T> _greedy;
+	ExactSteiner<T> _exact;
+	std::size_t _exactLimit = 20;
+};
+
+#endif
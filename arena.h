@@ -0,0 +1,120 @@
+#ifndef H_ARENA
+#define H_ARENA
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Bump allocator for short-lived scratch data. Allocation moves a pointer
+// inside the current block; reset() releases everything at once but keeps
+// the blocks, so once the arena has grown to its working size nothing is
+// allocated any more. One arena per thread, not thread-safe.
+class Arena
+{
+public:
+	explicit Arena(std::size_t blockSize = 1 << 16) : _blockSize(blockSize) {}
+
+	Arena(const Arena &) = delete;
+	Arena& operator=(const Arena &) = delete;
+
+	// Uninitialised storage for count objects of a trivially copyable type
+	template <class T>
+	T* allocate(std::size_t count)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Arena holds trivially copyable types only");
+		return (T*)allocateBytes(count * sizeof(T), alignof(T));
+	}
+
+	void reset()
+	{
+		_block = 0;
+		_offset = 0;
+	}
+
+private:
+	struct Block
+	{
+		std::unique_ptr<char[]> data;
+		std::size_t size;
+	};
+
+	void* allocateBytes(std::size_t bytes, std::size_t alignment)
+	{
+		for (;;)
+		{
+			if (_block < _blocks.size())
+			{
+				Block &b = _blocks[_block];
+				uintptr_t base = (uintptr_t)b.data.get();
+				std::size_t offset = (std::size_t)(((base + _offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+				if (offset + bytes <= b.size)
+				{
+					_offset = offset + bytes;
+					return b.data.get() + offset;
+				}
+
+				// Next block, or a new one big enough
+				_block++;
+				_offset = 0;
+				continue;
+			}
+
+			Block b;
+			b.size = std::max(_blockSize, bytes + alignment);
+			b.data.reset(new char[b.size]);
+			_blocks.push_back(std::move(b));
+		}
+	}
+
+	std::vector<Block> _blocks;
+	std::size_t _block = 0, _offset = 0;
+	std::size_t _blockSize;
+};
+
+// Growable array living in an arena, for scratch lists whose size is not
+// known up front. Growing copies into a larger piece of the arena; the old
+// piece is reclaimed by the arena's next reset().
+template <class T>
+class ArenaArray
+{
+public:
+	explicit ArenaArray(Arena &arena, std::size_t capacity = 16)
+		: _arena(&arena), _data(arena.allocate<T>(capacity)), _size(0), _capacity(capacity) {}
+
+	void push_back(const T &value)
+	{
+		if (_size == _capacity)
+		{
+			T *data = _arena->allocate<T>(_capacity * 2);
+			memcpy(data, _data, _size * sizeof(T));
+			_data = data;
+			_capacity *= 2;
+		}
+		_data[_size++] = value;
+	}
+
+	T& operator[](std::size_t i) { return _data[i]; }
+	const T& operator[](std::size_t i) const { return _data[i]; }
+	std::size_t size() const { return _size; }
+	bool empty() const { return _size == 0; }
+
+	T* begin() { return _data; }
+	T* end() { return _data + _size; }
+	const T* begin() const { return _data; }
+	const T* end() const { return _data + _size; }
+
+private:
+	Arena *_arena;
+	T *_data;
+	std::size_t _size, _capacity;
+};
+
+template <class T> T* begin(ArenaArray<T> &a) { return a.begin(); }
+template <class T> T* end(ArenaArray<T> &a) { return a.end(); }
+template <class T> const T* begin(const ArenaArray<T> &a) { return a.begin(); }
+template <class T> const T* end(const ArenaArray<T> &a) { return a.end(); }
+
+#endif
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdexcept>
+//-----------
+#include "nets.h"
+
+// Solves every net of a nets file (a line "net [name]" before the points of
+// each net) in parallel and reports the throughput. With a topology table
+// (see tablegen) the nets it covers, up to 4 terminals unless a larger
+// limit is given, take the small-net fast path.
+// Usage: batch <nets.txt> [exact limit] [table.smtt] [table max terminals]
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <nets.txt> [exact limit] [table.smtt] [table max terminals]\n", argv[0]);
+		return 1;
+	}
+
+	try
+	{
+		auto start = std::chrono::steady_clock::now();
+		NetList<float> nets = loadNets<float>(argv[1]);
+		double load = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		TopologyTable table;
+		BatchSolver<float> solver;
+		if (argc > 2) solver.setExactLimit((std::size_t)atoi(argv[2]));
+		if (argc > 3)
+		{
+			table.load(argv[3]);
+			if (argc > 4) solver.setTopologyTable(&table, (std::size_t)atoi(argv[4]));
+			else solver.setTopologyTable(&table);
+		}
+		const std::vector<SteinerSolution<float>> &results = solver.solve(nets);
+
+		double length = 0;
+		std::size_t optimal = 0, steiner = 0;
+		for (std::size_t i = 0; i < results.size(); i++)
+		{
+			length += results[i].length;
+			optimal += results[i].optimal;
+			steiner += results[i].points.size() - nets.count(i);
+		}
+
+		printf("Nets: %zu (%zu points), loaded in %.3f s\n", nets.size(), nets.points.size(), load);
+		printf("Solved in %.3f s, %.0f nets/s, %d threads\n", solver.getElapsed(), nets.size() / std::max(solver.getElapsed(), 1e-9), omp_get_max_threads());
+		printf("Total length: %.2f, Steiner points: %zu, exact: %zu\n", length, steiner, optimal);
+	}
+	catch (const char *error)
+	{
+		printf("%s\n", error);
+		return 1;
+	}
+	catch (const std::exception &error)
+	{
+		printf("%s\n", error.what());
+		return 1;
+	}
+
+	return 0;
+}
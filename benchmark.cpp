@@ -0,0 +1,501 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <omp.h>
+//-----------
+#include "vector2.h"
+#include "mesh.h"
+#include "delaunay.h"
+#include "delaunaydc.h"
+#include "steiner.h"
+#include "prim.h"
+#include "greedy.h"
+#include "incremental.h"
+#include "tiled.h"
+
+// Times every stage of the solver on synthetic inputs, for a range of sizes
+// and thread counts, and writes one row per run as CSV and/or JSON.
+// Usage: benchmark [--sizes 10,100,...] [--threads 1,2,...] [--inputs uniform,grid,...]
+//                  [--stages delaunay,dc,...] [--repeat N] [--greedy-limit N] [--tile-size N]
+//                  [--csv file] [--json file]
+//
+// The grid and lattice inputs are the cocircular worst case of the
+// triangulators, e.g. benchmark --inputs grid,uniform --stages delaunay,dc
+//
+// The incremental stage applies up to 1000 random inserts and removes to an
+// IncrementalSteiner of the input and fails unless its triangulation is
+// still Delaunay and its tree still spans the live terminals.
+//
+// The tiled stage solves the input with TiledSteiner (tiles of --tile-size
+// terminals) and fails unless the result is one tree over the terminals
+// and its own Steiner points, e.g.
+// benchmark --sizes 200000 --stages greedy,tiled --tile-size 20000
+
+using Clock = std::chrono::steady_clock;
+using Point = Vector2<float>;
+
+// Inputs ---------------------------------------------------------------------
+
+// Uniform in a 1000 x 1000 square
+std::vector<Point> uniformPoints(std::size_t n, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> u(0, 1000);
+	std::vector<Point> points;
+	for (std::size_t i = 0; i < n; i++) points.push_back(Point(u(rng), u(rng)));
+	return points;
+}
+
+// Gaussian clusters of different spread
+std::vector<Point> clusteredPoints(std::size_t n, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> u(0, 1000), spread(2, 40);
+	std::size_t clusters = std::max<std::size_t>(1, (std::size_t)sqrt((double)n) / 4);
+	std::vector<Point> centres;
+	std::vector<float> sigma;
+	for (std::size_t i = 0; i < clusters; i++)
+	{
+		centres.push_back(Point(u(rng), u(rng)));
+		sigma.push_back(spread(rng));
+	}
+
+	std::vector<Point> points;
+	std::uniform_int_distribution<std::size_t> pick(0, clusters - 1);
+	for (std::size_t i = 0; i < n; i++)
+	{
+		std::size_t c = pick(rng);
+		std::normal_distribution<float> g(0, sigma[c]);
+		points.push_back(Point(centres[c].x + g(rng), centres[c].y + g(rng)));
+	}
+	return points;
+}
+
+// Square lattice: every triangle has cocircular ties
+std::vector<Point> gridPoints(std::size_t n, std::mt19937 &)
+{
+	std::size_t side = (std::size_t)ceil(sqrt((double)n));
+	std::vector<Point> points;
+	for (std::size_t i = 0; i < n; i++) points.push_back(Point((float)(i % side), (float)(i / side)));
+	return points;
+}
+
+// Triangular lattice, equilateral triangles and repeated coordinates
+std::vector<Point> latticePoints(std::size_t n, std::mt19937 &)
+{
+	std::size_t side = (std::size_t)ceil(sqrt((double)n));
+	std::vector<Point> points;
+	for (std::size_t i = 0; i < n; i++)
+	{
+		std::size_t row = i / side;
+		points.push_back(Point((float)(i % side) + (row % 2 ? 0.5f : 0.0f), (float)row * 0.8660254f));
+	}
+	return points;
+}
+
+// Points within a hair of a few long lines
+std::vector<Point> collinearPoints(std::size_t n, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> u(0, 1000), t(0, 1);
+	std::normal_distribution<float> noise(0, 1e-3f);
+	Point a[4], b[4];
+	for (int l = 0; l < 4; l++) { a[l] = Point(u(rng), u(rng)); b[l] = Point(u(rng), u(rng)); }
+
+	std::vector<Point> points;
+	for (std::size_t i = 0; i < n; i++)
+	{
+		int l = (int)(i % 4);
+		float s = t(rng);
+		points.push_back(Point(a[l].x + s * (b[l].x - a[l].x) + noise(rng), a[l].y + s * (b[l].y - a[l].y) + noise(rng)));
+	}
+	return points;
+}
+
+// Layout-like: dense blocks on a coarse grid, pins along rows, some spread
+std::vector<Point> realisticPoints(std::size_t n, std::mt19937 &rng)
+{
+	std::uniform_real_distribution<float> u(0, 1000), block(0, 60);
+	std::uniform_int_distribution<int> kind(0, 9), track(0, 49);
+	std::vector<Point> points;
+	for (std::size_t i = 0; i < n; i++)
+	{
+		int k = kind(rng);
+		if (k < 5)
+		{
+			// Inside one of 16 x 16 macro blocks, snapped to a 0.5 pitch
+			float x = (float)track(rng) * 20 + block(rng) / 5, y = (float)track(rng) * 20 + block(rng) / 5;
+			points.push_back(Point(floorf(x * 2) / 2, floorf(y * 2) / 2));
+		}
+		else if (k < 8)
+			points.push_back(Point(floorf(u(rng)), (float)track(rng) * 20));	// On a row
+		else
+			points.push_back(Point(u(rng), u(rng)));
+	}
+	return points;
+}
+
+struct Input
+{
+	const char *name;
+	std::vector<Point> (*generate)(std::size_t, std::mt19937 &);
+};
+
+const Input inputs[] = {
+	{ "uniform", uniformPoints },
+	{ "clustered", clusteredPoints },
+	{ "grid", gridPoints },
+	{ "lattice", latticePoints },
+	{ "collinear", collinearPoints },
+	{ "realistic", realisticPoints },
+};
+
+// Runs -----------------------------------------------------------------------
+
+struct Result
+{
+	std::string input;
+	std::size_t size = 0;
+	int threads = 0;
+	double delaunay = -1, delaunayDC = -1, steiner = -1, mst = -1, greedy = -1;	// ms, -1 = skipped
+	double incremental = -1;	// us per update
+	double tiled = -1;			// ms
+	std::size_t triangles = 0, candidates = 0;
+	double mstLength = 0, greedyLength = 0, incrementalLength = 0, tiledLength = 0;
+};
+
+template <class F>
+double timeIt(int repeat, F run)
+{
+	double best = 1e300;
+	for (int r = 0; r < repeat; r++)
+	{
+		Clock::time_point start = Clock::now();
+		run();
+		best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+	return best;
+}
+
+// Checks ---------------------------------------------------------------------
+
+// Every edge between two inner triangles is locally Delaunay, so the inner
+// triangulation is Delaunay as a whole
+template <class T>
+void checkDelaunay(const DynamicDelaunay<T> &dt)
+{
+	const std::vector<Vector2<T>> &p = dt.getPoints();
+	for (int c = 0; c < (int)dt.cellCount(); c++)
+	{
+		if (!dt.isCell(c) || !dt.isInner(c)) continue;
+		const int *v = dt.getCell(c);
+		double side = orient2d(p[v[0]], p[v[1]], p[v[2]]) > 0 ? 1 : -1;
+		for (int k = 0; k < 3; k++)
+		{
+			int n = dt.getNeighbour(c, k);
+			if (n < 0 || !dt.isInner(n)) continue;
+			const int *w = dt.getCell(n);
+			for (int j = 0; j < 3; j++)
+				if (w[j] != v[k] && w[j] != v[(k + 1) % 3] && side * incircle(p[v[0]], p[v[1]], p[v[2]], p[w[j]]) > 0)
+					throw std::runtime_error("Incremental triangulation is not Delaunay");
+		}
+	}
+}
+
+// One tree over all the points, as long as it claims to be
+template <class T>
+void checkTree(const SteinerSolution<T> &solution, const char *solver)
+{
+	const std::size_t n = solution.points.size();
+	DisjointSet set;
+	set.reset(n);
+	double length = 0;
+	bool ok = solution.tree.size() + 1 == std::max<std::size_t>(n, 1);
+	for (auto e = begin(solution.tree); ok && e != end(solution.tree); e++)
+	{
+		ok = e->a < n && e->b < n && set.unite(e->a, e->b);
+		if (ok) length += EuclideanMST<T>::length(solution.points[e->a], solution.points[e->b]);
+	}
+	if (!ok || fabs(length - solution.length) > 1e-4 * (1 + length))
+		throw std::runtime_error(std::string(solver) + " did not return a spanning tree of its points");
+}
+
+const char *const stageNames[] = { "delaunay", "dc", "steiner", "mst", "greedy", "incremental", "tiled" };
+const int stageCount = sizeof(stageNames) / sizeof(stageNames[0]);
+enum Stage { StageDelaunay = 1, StageDC = 2, StageSteiner = 4, StageMST = 8, StageGreedy = 16, StageIncremental = 32, StageTiled = 64, StageAll = 127 };
+
+Result benchmark(const Input &input, std::size_t size, int threads, int repeat, std::size_t greedyLimit, std::size_t tileSize, int stages)
+{
+	std::mt19937 rng(12345);
+	std::vector<Point> points = input.generate(size, rng);
+	omp_set_num_threads(threads);
+
+	Result r;
+	r.input = input.name;
+	r.size = size;
+	r.threads = threads;
+
+	if (stages & StageDelaunay)
+	{
+		Delaunay<float> incremental;
+		r.delaunay = timeIt(repeat, [&]() { r.triangles = incremental.triangulate(points).triangles.size(); });
+	}
+
+	// The later stages need the mesh, built untimed if dc is not asked for
+	DelaunayDC<float> dc;
+	const Mesh<float> *mesh = nullptr;
+	if (stages & (StageDC | StageSteiner | StageGreedy))
+	{
+		r.delaunayDC = timeIt(stages & StageDC ? repeat : 1, [&]() { mesh = &dc.triangulate(points); });
+		if (!(stages & StageDC)) r.delaunayDC = -1;
+		r.triangles = mesh->triangles.size();
+	}
+
+	Steiner<float> steiner;
+	std::vector<Point> candidates;
+	if (stages & (StageSteiner | StageGreedy))
+	{
+		r.steiner = timeIt(stages & StageSteiner ? repeat : 1, [&]() { candidates = steiner.additionalVertices(*mesh); });
+		if (!(stages & StageSteiner)) r.steiner = -1;
+		r.candidates = candidates.size();
+	}
+
+	if (stages & StageMST)
+	{
+		Prim<float> prim;
+		r.mst = timeIt(repeat, [&]() { r.mstLength = prim.delaunayMST(points); });
+	}
+
+	if ((stages & StageGreedy) && size <= greedyLimit)
+	{
+		GreedySteiner<float> greedy;
+		r.greedy = timeIt(repeat, [&]() { r.greedyLength = greedy.solve(points, candidates); });
+	}
+
+	// One run: the updates change the net, --repeat does not apply
+	if ((stages & StageIncremental) && size <= greedyLimit)
+	{
+		IncrementalSteiner<float> incremental;
+		incremental.reset(points);
+		std::vector<uint32_t> ids;
+		std::vector<Point> terminal(points);
+		for (uint32_t i = 0; i < points.size(); i++) ids.push_back(i);
+
+		// Half inserts from the same distribution, half removes
+		const std::size_t updates = std::min<std::size_t>(size, 1000);
+		std::vector<Point> added = input.generate(updates, rng);
+		Clock::time_point start = Clock::now();
+		for (std::size_t u = 0; u < updates; u++)
+		{
+			if (u % 2 && !ids.empty())
+			{
+				std::size_t k = rng() % ids.size();
+				incremental.remove(ids[k]);
+				ids[k] = ids.back();
+				ids.pop_back();
+				continue;
+			}
+
+			uint32_t id = incremental.insert(added[u]);
+			if (terminal.size() <= id) terminal.resize(id + 1);
+			terminal[id] = added[u];
+			ids.push_back(id);
+		}
+		r.incremental = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / std::max<std::size_t>(updates, 1);
+
+		// The live terminals come first, in id order
+		checkDelaunay(incremental.getTriangulation());
+		SteinerSolution<float> solution = incremental.getSolution();
+		checkTree(solution, "IncrementalSteiner");
+		std::sort(begin(ids), end(ids));
+		for (std::size_t i = 0; i < ids.size(); i++)
+			if (i >= solution.points.size() || !(solution.points[i] == terminal[ids[i]]))
+				throw std::runtime_error("IncrementalSteiner lost a terminal");
+		r.incrementalLength = solution.length;
+	}
+
+	// Meant for sets past the greedy limit, so not bound by it
+	if (stages & StageTiled)
+	{
+		TiledSteiner<float> tiled;
+		tiled.setTileSize(tileSize);
+		const SteinerSolution<float> *solution = nullptr;
+		r.tiled = timeIt(repeat, [&]() { solution = &tiled.solve(points); });
+
+		// The terminals come first, as given
+		checkTree(*solution, "TiledSteiner");
+		for (std::size_t i = 0; i < points.size(); i++)
+			if (i >= solution->points.size() || !(solution->points[i] == points[i]))
+				throw std::runtime_error("TiledSteiner lost a terminal");
+		r.tiledLength = solution->length;
+	}
+
+	return r;
+}
+
+// Output ---------------------------------------------------------------------
+
+void writeCSV(FILE *file, const std::vector<Result> &results)
+{
+	fprintf(file, "input,size,threads,delaunay_ms,delaunaydc_ms,steiner_ms,mst_ms,greedy_ms,incremental_us,tiled_ms,triangles,"
+		"candidates,mst_length,greedy_length,incremental_length,tiled_length\n");
+	for (auto r = begin(results); r != end(results); r++)
+		fprintf(file, "%s,%zu,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%zu,%zu,%.3f,%.3f,%.3f,%.3f\n", r->input.c_str(), r->size, r->threads,
+			r->delaunay, r->delaunayDC, r->steiner, r->mst, r->greedy, r->incremental, r->tiled, r->triangles, r->candidates,
+			r->mstLength, r->greedyLength, r->incrementalLength, r->tiledLength);
+}
+
+void writeJSON(FILE *file, const std::vector<Result> &results)
+{
+	fprintf(file, "[\n");
+	for (std::size_t i = 0; i < results.size(); i++)
+	{
+		const Result &r = results[i];
+		fprintf(file, "  {\"input\": \"%s\", \"size\": %zu, \"threads\": %d, \"delaunay_ms\": %.3f, \"delaunaydc_ms\": %.3f, "
+			"\"steiner_ms\": %.3f, \"mst_ms\": %.3f, \"greedy_ms\": %.3f, \"incremental_us\": %.3f, \"tiled_ms\": %.3f, "
+			"\"triangles\": %zu, \"candidates\": %zu, \"mst_length\": %.3f, \"greedy_length\": %.3f, \"incremental_length\": %.3f, "
+			"\"tiled_length\": %.3f}%s\n",
+			r.input.c_str(), r.size, r.threads, r.delaunay, r.delaunayDC, r.steiner, r.mst, r.greedy, r.incremental, r.tiled,
+			r.triangles, r.candidates, r.mstLength, r.greedyLength, r.incrementalLength, r.tiledLength, i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "]\n");
+}
+
+std::vector<std::string> split(const char *list)
+{
+	std::vector<std::string> items;
+	std::string item;
+	for (const char *c = list; ; c++)
+	{
+		if (*c == ',' || *c == 0)
+		{
+			if (!item.empty()) items.push_back(item);
+			item.clear();
+			if (*c == 0) break;
+		}
+		else item += *c;
+	}
+	return items;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::size_t> sizes = { 10, 100, 1000, 10000, 100000, 1000000 };
+	std::vector<int> threads;
+	for (int t = 1; t < omp_get_max_threads(); t *= 2) threads.push_back(t);
+	threads.push_back(omp_get_max_threads());
+	std::vector<std::string> names;
+	for (auto i = std::begin(inputs); i != std::end(inputs); i++) names.push_back(i->name);
+	int repeat = 3;
+	std::size_t greedyLimit = 100000;
+	std::size_t tileSize = 50000;
+	int stages = StageAll;
+	const char *csv = nullptr, *json = nullptr;
+
+	for (int a = 1; a < argc; a++)
+	{
+		const char *value = a + 1 < argc ? argv[a + 1] : nullptr;
+		if (!value)
+		{
+			printf("Missing value for %s\n", argv[a]);
+			return 1;
+		}
+
+		if (strcmp(argv[a], "--sizes") == 0)
+		{
+			sizes.clear();
+			for (auto &s : split(value)) sizes.push_back((std::size_t)atoll(s.c_str()));
+		}
+		else if (strcmp(argv[a], "--threads") == 0)
+		{
+			threads.clear();
+			for (auto &s : split(value)) threads.push_back(std::max(atoi(s.c_str()), 1));
+		}
+		else if (strcmp(argv[a], "--inputs") == 0) names = split(value);
+		else if (strcmp(argv[a], "--stages") == 0)
+		{
+			stages = 0;
+			for (auto &s : split(value))
+			{
+				int bit = 0;
+				for (int i = 0; i < stageCount; i++)
+					if (s == stageNames[i]) bit = 1 << i;
+				if (!bit)
+				{
+					printf("Unknown stage %s\n", s.c_str());
+					return 1;
+				}
+				stages |= bit;
+			}
+		}
+		else if (strcmp(argv[a], "--repeat") == 0) repeat = std::max(atoi(value), 1);
+		else if (strcmp(argv[a], "--greedy-limit") == 0) greedyLimit = (std::size_t)atoll(value);
+		else if (strcmp(argv[a], "--tile-size") == 0) tileSize = (std::size_t)atoll(value);
+		else if (strcmp(argv[a], "--csv") == 0) csv = value;
+		else if (strcmp(argv[a], "--json") == 0) json = value;
+		else
+		{
+			printf("Unknown option %s\n", argv[a]);
+			return 1;
+		}
+		a++;
+	}
+
+	std::vector<Result> results;
+	try
+	{
+		for (auto &name : names)
+		{
+			const Input *input = nullptr;
+			for (auto i = std::begin(inputs); i != std::end(inputs); i++)
+				if (name == i->name) input = i;
+			if (!input)
+			{
+				printf("Unknown input %s\n", name.c_str());
+				return 1;
+			}
+
+			for (auto size : sizes)
+				for (auto t : threads)
+				{
+					results.push_back(benchmark(*input, size, t, repeat, greedyLimit, tileSize, stages));
+					const Result &r = results.back();
+					fprintf(stderr, "%-10s %8zu points %2d threads: delaunay %.1f, dc %.1f, steiner %.1f, mst %.1f, greedy %.1f ms, "
+						"incremental %.1f us, tiled %.1f ms\n", r.input.c_str(), r.size, r.threads, r.delaunay, r.delaunayDC, r.steiner,
+						r.mst, r.greedy, r.incremental, r.tiled);
+				}
+		}
+	}
+	catch (const char *error)
+	{
+		printf("%s\n", error);
+		return 1;
+	}
+	catch (const std::exception &error)
+	{
+		printf("%s\n", error.what());
+		return 1;
+	}
+
+	if (csv)
+	{
+		FILE *file = fopen(csv, "w");
+		if (!file) { printf("Cant open %s\n", csv); return 1; }
+		writeCSV(file, results);
+		fclose(file);
+	}
+	if (json)
+	{
+		FILE *file = fopen(json, "w");
+		if (!file) { printf("Cant open %s\n", json); return 1; }
+		writeJSON(file, results);
+		fclose(file);
+	}
+	if (!csv && !json) writeCSV(stdout, results);
+
+	return 0;
+}
@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdexcept>
+//-----------
+#include "pointset.h"
+
+// Converts a text point file (as in files/good.dat) into the binary point set format
+// Usage: convert <input.dat> <output.smtp> [float|double|int]
+int main(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		printf("Usage: %s <input.dat> <output.smtp> [float|double|int]\n", argv[0]);
+		return 1;
+	}
+
+	const char *type = argc > 3 ? argv[3] : "float";
+
+	try
+	{
+		std::size_t count;
+		if (strcmp(type, "double") == 0) count = convertPointSet<double>(argv[1], argv[2]);
+		else if (strcmp(type, "int") == 0) count = convertPointSet<int32_t>(argv[1], argv[2]);
+		else count = convertPointSet<float>(argv[1], argv[2]);
+
+		printf("%zu points written to %s\n", count, argv[2]);
+	}
+	catch (const char *error)
+	{
+		printf("%s\n", error);
+		return 1;
+	}
+	catch (const std::exception &error)
+	{
+		printf("%s\n", error.what());
+		return 1;
+	}
+
+	return 0;
+}
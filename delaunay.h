@@ -4,6 +4,13 @@
 #include "vector2.h"
 #include "edge.h"
 #include "triangle.h"
+#include "mesh.h"
+#include "loader.h"
+#include "pointset.h"
+#include "ordering.h"
+#include "predicates.h"
+#include "profile.h"
+#include "arena.h"
 
 #include <vector>
 #include <algorithm>
@@ -17,135 +24,311 @@ public:
 	using TriangleType = Triangle<T>;
 	using EdgeType = Edge<T>;
 	using VertexType = Vector2<T>;
+	using MeshType = Mesh<T>;
 
-	const std::vector<TriangleType>& Load(char* Path)
+	const MeshType& Load(char* Path)
 	{
-		std::vector<Vector2<float>> points;
-		std::ifstream file(Path, std::ios_base::in);
-		if (!file.is_open()) throw "Cant open file / Wrong way";
-
-		int size = 0;
-		while (!file.eof())
-		{
-			file.getline(new char[255], 255);
-			size++;
-		}
-		file.seekg(0);
-
-		for (int i = 0; i < size; i++)
+		if (isPointSetFile(Path))
 		{
-			int a, b; file >> a; file >> b;
-			points.push_back(Vector2<float>(a, b));
+			PointSetView<T> points(Path);
+			return triangulate(points.data(), points.size());
 		}
-		file.seekg(0);
 
+		std::vector<VertexType> points = loadPoints<T>(Path);
 		return triangulate(points);
 	}
 
-	const std::vector<TriangleType>& triangulate(std::vector<VertexType> &vertices)
+	const MeshType& triangulate(std::vector<VertexType> &vertices)
+	{
+		return triangulate(vertices.data(), vertices.size());
+	}
+
+	const MeshType& triangulate(const VertexType *vertices, std::size_t count)
 	{	
-		
+		PROFILE_SCOPE("Delaunay::triangulate");
+
+		_mesh.clear();
+		_triangles.clear();
+		_edges.clear();
+		_cells.clear();
+		_free.clear();
+
 		// Store the vertices localy
-		_vertices = vertices;
+		_mesh.vertices.assign(vertices, vertices + count);
+		if (count == 0) return _mesh;
+
+		// Super triangle vertices live right after the input vertices. Its
+		// corners are symbolic (see orient2dSuper), so any input fits inside
+		// and the stored values are mere placeholders.
+		const int n = (int)count;
+		_super = n;
+		_mesh.vertices.resize(count + 3);
+		const std::vector<VertexType> &points = _mesh.vertices;
+		_fanStart.resize(count + 3);
+
+		// Create a list of triangles, and add the supertriangle in it (counter-clockwise)
+		_cells.push_back(Cell(n, n + 1, n + 2));
 
-		// Determinate the super triangle
-		float minX = vertices[0].x;
-		float minY = vertices[0].y;
-		float maxX = minX;
-		float maxY = minY;
+		// Spatially coherent order keeps the walks short and the memory access local
+		std::vector<int> order = insertionOrder(vertices, count, _order);
 
-		for (std::size_t i = 0; i < vertices.size(); ++i)
+		CellRef last = { 0, 0 };
+		for (auto i = begin(order); i != end(order); i++)
 		{
-			if (vertices[i].x < minX) minX = vertices[i].x;
-			if (vertices[i].y < minY) minY = vertices[i].y;
-			if (vertices[i].x > maxX) maxX = vertices[i].x;
-			if (vertices[i].y > maxY) maxY = vertices[i].y;
-		}
+			const int p = *i;
 
-		float dx = maxX - minX;
-		float dy = maxY - minY;
-		float deltaMax = std::max(dx, dy);
-		float midx = (minX + maxX) / 2.f;
-		float midy = (minY + maxY) / 2.f;
+			// Locate the triangle containing the point, starting from the last inserted one
+			int t = locate(isValid(last) ? last.index : anyCell(), p);
 
-		VertexType p1(midx - 20 * deltaMax, midy - deltaMax);
-		VertexType p2(midx, midy + 20 * deltaMax);
-		VertexType p3(midx + 20 * deltaMax, midy - deltaMax);
+			// Skip duplicate vertices, they would only produce degenerate triangles
+			const Cell &c = _cells[t];
+			if ((c.v[0] < n && points[c.v[0]] == points[p]) || (c.v[1] < n && points[c.v[1]] == points[p])
+				|| (c.v[2] < n && points[c.v[2]] == points[p]))
+				continue;
 
-		// Create a list of triangles, and add the supertriangle in it
-		_triangles.push_back(TriangleType(p1, p2, p3));	
+			// Scratch lists of this insertion, from the arena
+			_arena.reset();
+			ArenaArray<int> cavity(_arena), fan(_arena);
+			ArenaArray<Boundary> polygon(_arena);
 
-		for (auto p = begin(vertices); p != end(vertices); p++)
-		{
-			std::vector<EdgeType> polygon;
-			
-			for (auto t = begin(_triangles); t != end(_triangles); t++)
+			// Grow the cavity of bad triangles by flood-fill over neighbours
+			cavity.push_back(t);
+			_cells[t].isBad = true;
+
+			for (std::size_t i = 0; i < cavity.size(); i++)
 			{
-				// Processing
-				if (t->circumCircleContains(*p))
+				for (int k = 0; k < 3; k++)
 				{
-					// Pushing bad triangle
-					t->isBad = true;
-					polygon.push_back(t->e1);
-					polygon.push_back(t->e2);
-					polygon.push_back(t->e3);
-				}
-				else
-				{
-					//std::cout << " does not contains " << *p << " in his circum center" << std::endl;
+					int nb = _cells[cavity[i]].n[k];
+					if (nb < 0 || _cells[nb].isBad) continue;
+
+					PROFILE_COUNT(IncircleTests);
+					if (circumCircleContains(_cells[nb], p))
+					{
+						_cells[nb].isBad = true;
+						cavity.push_back(nb);
+					}
 				}
 			}
 
-			_triangles.erase(std::remove_if(begin(_triangles), end(_triangles), [](TriangleType &t) {
-				return t.isBad;
-			}), end(_triangles));
+			PROFILE_ADD(CavitySize, cavity.size());
 
-			for (auto e1 = begin(polygon); e1 != end(polygon); e1++)
+			// Edges between a bad triangle and a good one (or the hull) form the cavity boundary
+			for (auto b = begin(cavity); b != end(cavity); b++)
 			{
-				for (auto e2 = begin(polygon); e2 != end(polygon); e2++)
+				for (int k = 0; k < 3; k++)
 				{
-					if (e1 == e2)
-						continue;
+					int nb = _cells[*b].n[k];
+					if (nb < 0 || !_cells[nb].isBad)
+						polygon.push_back(Boundary(_cells[*b].v[k], _cells[*b].v[(k + 1) % 3], nb, *b));
+				}
+			}
 
-					if (*e1 == *e2)
-					{
-						e1->isBad = true;
-						e2->isBad = true;
-					}
+			// Connect the point with every boundary edge. The new triangles
+			// reuse slots freed by earlier insertions, never the cavity's own:
+			// the outer neighbours are matched by the old indices below.
+			for (auto e = begin(polygon); e != end(polygon); e++)
+			{
+				int id = allocateCell(e->a, e->b, p);
+				_cells[id].n[0] = e->outer;
+				if (e->outer >= 0)
+				{
+					Cell &outer = _cells[e->outer];
+					for (int k = 0; k < 3; k++)
+						if (outer.n[k] == e->inner) outer.n[k] = id;
 				}
+				fan.push_back(id);
 			}
 
-			polygon.erase(std::remove_if(begin(polygon), end(polygon), [](EdgeType &e) {
-				return e.isBad;
-			}), end(polygon));
+			for (auto b = begin(cavity); b != end(cavity); b++)
+				releaseCell(*b);
 
-			for (auto e = begin(polygon); e != end(polygon); e++)
-				_triangles.push_back(TriangleType(e->p1, e->p2, *p));
+			// Link the new triangles with each other around the point: the
+			// boundary is a closed loop, the triangle after a -> b starts at b
+			for (auto i = begin(fan); i != end(fan); i++)
+				_fanStart[_cells[*i].v[0]] = *i;
+			for (auto i = begin(fan); i != end(fan); i++)
+			{
+				int j = _fanStart[_cells[*i].v[1]];
+				_cells[*i].n[1] = j;
+				_cells[j].n[2] = *i;
+			}
 
+			last = CellRef{ fan[0], _cells[fan[0]].generation };
 		}
 
-		_triangles.erase(std::remove_if(begin(_triangles), end(_triangles), [p1, p2, p3](TriangleType &t) {
-			return t.containsVertex(p1) || t.containsVertex(p2) || t.containsVertex(p3);
-		}), end(_triangles));
-
-		for (auto t = begin(_triangles); t != end(_triangles); t++)
+		for (auto t = begin(_cells); t != end(_cells); t++)
 		{
-			_edges.push_back(t->e1);
-			_edges.push_back(t->e2);
-			_edges.push_back(t->e3);
+			if (t->isDead || t->v[0] >= n || t->v[1] >= n || t->v[2] >= n)
+				continue;
+
+			_mesh.triangles.push_back(IndexTriangle(t->v[0], t->v[1], t->v[2]));
+
+			// Every edge once: from the lower index side, or from its only triangle
+			for (int k = 0; k < 3; k++)
+			{
+				int a = t->v[k], b = t->v[(k + 1) % 3], nb = t->n[k];
+				bool hull = nb < 0 || _cells[nb].v[0] >= n || _cells[nb].v[1] >= n || _cells[nb].v[2] >= n;
+				if (a < b || hull)
+					_mesh.edges.push_back(IndexEdge(a, b));
+			}
 		}
 
-		return _triangles;
+		_mesh.vertices.resize(n);
+		_cells.clear();
+		_free.clear();
+
+		return _mesh;
 	}
 
-	const std::vector<TriangleType>& getTriangles() const { return _triangles; };
-	const std::vector<EdgeType>& getEdges() const { return _edges; };
-	const std::vector<VertexType>& getVertices() const { return _vertices; };
+	// Insertion order of the points, BRIO by default
+	void setInsertionOrder(InsertionOrder order) { _order = order; };
+	InsertionOrder getInsertionOrder() const { return _order; };
+
+	const MeshType& getMesh() const { return _mesh; };
+	const std::vector<VertexType>& getVertices() const { return _mesh.vertices; };
+
+	// Value-copied triangles and edges, built on first use
+	const std::vector<TriangleType>& getTriangles() const
+	{
+		if (_triangles.empty())
+			for (auto t = begin(_mesh.triangles); t != end(_mesh.triangles); t++)
+				_triangles.push_back(TriangleType(_mesh.vertex(*t, 0), _mesh.vertex(*t, 1), _mesh.vertex(*t, 2)));
+		return _triangles;
+	};
+
+	const std::vector<EdgeType>& getEdges() const
+	{
+		if (_edges.empty())
+			for (auto e = begin(_mesh.edges); e != end(_mesh.edges); e++)
+				_edges.push_back(EdgeType(_mesh.vertices[e->a], _mesh.vertices[e->b]));
+		return _edges;
+	};
 
 private:
-	std::vector<TriangleType> _triangles;
-	std::vector<EdgeType> _edges;
-	std::vector<VertexType> _vertices;
+	// Working triangle: vertex indices in counter-clockwise order and
+	// neighbours, n[i] lies across the edge v[i] -> v[i + 1] (-1 on the hull).
+	// The generation is bumped whenever the slot is freed.
+	struct Cell
+	{
+		Cell(int a, int b, int c) : generation(0), isBad(false), isDead(false)
+		{
+			set(a, b, c);
+		}
+
+		void set(int a, int b, int c)
+		{
+			v[0] = a; v[1] = b; v[2] = c;
+			n[0] = n[1] = n[2] = -1;
+			isBad = isDead = false;
+		}
+
+		int v[3];
+		int n[3];
+		unsigned int generation;
+		bool isBad;
+		bool isDead;
+	};
+
+	// Reference to a cell that may be freed in the meantime
+	struct CellRef
+	{
+		int index;
+		unsigned int generation;
+	};
+
+	// Cavity boundary edge a -> b, with the triangles on both sides of it
+	struct Boundary
+	{
+		Boundary(int a, int b, int outer, int inner) : a(a), b(b), outer(outer), inner(inner) {}
+
+		int a, b;
+		int outer;
+		int inner;
+	};
+
+	// New cell in a freed slot if there is one
+	int allocateCell(int a, int b, int c)
+	{
+		if (_free.empty())
+		{
+			_cells.push_back(Cell(a, b, c));
+			return (int)_cells.size() - 1;
+		}
+
+		int id = _free.back();
+		_free.pop_back();
+		_cells[id].set(a, b, c);
+		return id;
+	}
+
+	void releaseCell(int id)
+	{
+		_cells[id].isDead = true;
+		_cells[id].generation++;
+		_free.push_back(id);
+	}
+
+	bool isValid(CellRef ref) const
+	{
+		return ref.index >= 0 && ref.index < (int)_cells.size() && _cells[ref.index].generation == ref.generation && !_cells[ref.index].isDead;
+	}
+
+	// Some live cell, the most recently created one
+	int anyCell() const
+	{
+		for (int i = (int)_cells.size() - 1; i >= 0; i--)
+			if (!_cells[i].isDead) return i;
+		return 0;
+	}
+
+	// Corner of the super triangle, -1 for an input vertex
+	int corner(int v) const { return v >= _super ? v - _super : -1; }
+
+	bool circumCircleContains(const Cell &t, int p) const
+	{
+		const std::vector<VertexType> &v = _mesh.vertices;
+		return incircleSuper(v[t.v[0]], corner(t.v[0]), v[t.v[1]], corner(t.v[1]), v[t.v[2]], corner(t.v[2]), v[p], -1) > 0;
+	}
+
+	// Visibility walk from triangle t towards point p
+	int locate(int t, int p)
+	{
+		const VertexType &v = _mesh.vertices[p];
+
+		for (;;)
+		{
+			const Cell &c = _cells[t];
+			int next = -1;
+
+			// Start from a varying edge so the walk cannot cycle
+			unsigned int k0 = (_seed = _seed * 1103515245u + 12345u) >> 16;
+			for (int i = 0; i < 3 && next < 0; i++)
+			{
+				int k = (int)((k0 + i) % 3);
+				int a = c.v[k], b = c.v[(k + 1) % 3];
+				if (c.n[k] >= 0 && orient2dSuper(_mesh.vertices[a], corner(a), _mesh.vertices[b], corner(b), v, -1) < 0)
+					next = c.n[k];
+			}
+
+			if (next < 0) return t;
+			t = next;
+		}
+	}
+
+	// Triangle pool: freed slots are listed in _free and reused, so the
+	// pool stays at the size of the live triangulation
+	std::vector<Cell> _cells;
+	std::vector<int> _free;
+	std::vector<int> _fanStart;		// Fan triangle starting at each vertex, valid during one insertion
+	int _super = 0;					// First super triangle vertex, right after the input
+	Arena _arena;
+	unsigned int _seed = 1;
+	InsertionOrder _order = InsertionOrder::BRIO;
+
+	MeshType _mesh;
+	mutable std::vector<TriangleType> _triangles;
+	mutable std::vector<EdgeType> _edges;
 };
 
 #endif
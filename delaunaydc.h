@@ -0,0 +1,361 @@
+#ifndef H_DELAUNAYDC
+#define H_DELAUNAYDC
+
+#include "vector2.h"
+#include "edge.h"
+#include "triangle.h"
+#include "mesh.h"
+#include "loader.h"
+#include "pointset.h"
+#include "predicates.h"
+#include "profile.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <omp.h>
+
+// Divide-and-conquer Delaunay triangulation (Guibas & Stolfi) on a quad-edge
+// structure. The point set is split by median cuts along x, both halves are
+// triangulated in parallel with OpenMP tasks and then merged along the seam.
+template <class T>
+class DelaunayDC
+{
+
+public:
+	using TriangleType = Triangle<T>;
+	using EdgeType = Edge<T>;
+	using VertexType = Vector2<T>;
+	using MeshType = Mesh<T>;
+
+	const MeshType& Load(char* Path)
+	{
+		if (isPointSetFile(Path))
+		{
+			PointSetView<T> points(Path);
+			return triangulate(points.data(), points.size());
+		}
+
+		std::vector<VertexType> points = loadPoints<T>(Path);
+		return triangulate(points);
+	}
+
+	const MeshType& triangulate(std::vector<VertexType> &vertices)
+	{
+		return triangulate(vertices.data(), vertices.size());
+	}
+
+	const MeshType& triangulate(const VertexType *vertices, std::size_t count)
+	{
+		PROFILE_SCOPE("DelaunayDC::triangulate");
+
+		_mesh.clear();
+		_triangles.clear();
+		_edges.clear();
+
+		// Store the vertices localy
+		_mesh.vertices.assign(vertices, vertices + count);
+
+		// Sort by x (then y) so every split is a median cut, and drop duplicates
+		_order.resize(count);
+		for (std::size_t i = 0; i < _order.size(); i++) _order[i] = (int)i;
+
+		std::sort(begin(_order), end(_order), [&](int a, int b) {
+			return vertices[a].x < vertices[b].x || (vertices[a].x == vertices[b].x && vertices[a].y < vertices[b].y);
+		});
+		_order.erase(std::unique(begin(_order), end(_order), [&](int a, int b) {
+			return vertices[a] == vertices[b];
+		}), end(_order));
+
+		if (_order.size() < 2) return _mesh;
+
+		// The pools keep their blocks from the last call, they are only emptied
+		for (auto pool = begin(_pools); pool != end(_pools); pool++) pool->clear();
+
+		#pragma omp parallel
+		#pragma omp single
+		{
+			// One pool per thread of the team actually running, which is a
+			// single thread when called from inside another parallel region
+			if (_pools.size() < (std::size_t)omp_get_num_threads()) _pools.resize(omp_get_num_threads());
+			build(0, (int)_order.size());
+		}
+
+		collect();
+
+		return _mesh;
+	}
+
+	const MeshType& getMesh() const { return _mesh; };
+	const std::vector<VertexType>& getVertices() const { return _mesh.vertices; };
+
+	// Value-copied triangles and edges, built on first use
+	const std::vector<TriangleType>& getTriangles() const
+	{
+		if (_triangles.empty())
+			for (auto t = begin(_mesh.triangles); t != end(_mesh.triangles); t++)
+				_triangles.push_back(TriangleType(_mesh.vertex(*t, 0), _mesh.vertex(*t, 1), _mesh.vertex(*t, 2)));
+		return _triangles;
+	};
+
+	const std::vector<EdgeType>& getEdges() const
+	{
+		if (_edges.empty())
+			for (auto e = begin(_mesh.edges); e != end(_mesh.edges); e++)
+				_edges.push_back(EdgeType(_mesh.vertices[e->a], _mesh.vertices[e->b]));
+		return _edges;
+	};
+
+private:
+	// Directed edge of the quad-edge structure
+	struct QuadEdge
+	{
+		QuadEdge *rot;
+		QuadEdge *onext;
+		int origin;
+		bool isDead;
+		bool isUsed;
+	};
+
+	// Edge record: e[0] and e[2] are the primal edges, e[1] and e[3] the dual ones
+	struct Quad
+	{
+		QuadEdge e[4];
+	};
+
+	// Quads in fixed blocks, so their addresses never change. clear() keeps
+	// the blocks for the next triangulation.
+	class QuadPool
+	{
+	public:
+		Quad* add()
+		{
+			if (_used == _blocks.size() * blockSize) _blocks.push_back(std::unique_ptr<Quad[]>(new Quad[blockSize]));
+			Quad *q = &_blocks[_used / blockSize][_used % blockSize];
+			_used++;
+			return q;
+		}
+
+		void clear() { _used = 0; }
+		std::size_t size() const { return _used; }
+		Quad& operator[](std::size_t i) { return _blocks[i / blockSize][i % blockSize]; }
+
+	private:
+		static const std::size_t blockSize = 256;
+
+		std::vector<std::unique_ptr<Quad[]>> _blocks;
+		std::size_t _used = 0;
+	};
+
+	using Pair = std::pair<QuadEdge*, QuadEdge*>;
+
+	// Subproblems smaller than this are not worth a task of their own
+	static const int taskCutoff = 4096;
+
+	static QuadEdge* sym(QuadEdge *e) { return e->rot->rot; }
+	static QuadEdge* invRot(QuadEdge *e) { return e->rot->rot->rot; }
+	static QuadEdge* oprev(QuadEdge *e) { return e->rot->onext->rot; }
+	static QuadEdge* lnext(QuadEdge *e) { return invRot(e)->onext->rot; }
+	static QuadEdge* rprev(QuadEdge *e) { return sym(e)->onext; }
+	static int org(QuadEdge *e) { return e->origin; }
+	static int dest(QuadEdge *e) { return sym(e)->origin; }
+
+	QuadEdge* makeEdge(int a, int b)
+	{
+		// Every thread allocates from its own pool, so no locking is needed
+		QuadEdge *e = _pools[omp_get_thread_num()].add()->e;
+
+		for (int r = 0; r < 4; r++)
+		{
+			e[r].rot = &e[(r + 1) % 4];
+			e[r].isDead = false;
+			e[r].isUsed = false;
+			e[r].origin = -1;
+		}
+		e[0].onext = &e[0]; e[2].onext = &e[2];
+		e[1].onext = &e[3]; e[3].onext = &e[1];
+		e[0].origin = a; e[2].origin = b;
+		return e;
+	}
+
+	static void splice(QuadEdge *a, QuadEdge *b)
+	{
+		QuadEdge *alpha = a->onext->rot;
+		QuadEdge *beta = b->onext->rot;
+		std::swap(a->onext, b->onext);
+		std::swap(alpha->onext, beta->onext);
+	}
+
+	QuadEdge* connect(QuadEdge *a, QuadEdge *b)
+	{
+		QuadEdge *e = makeEdge(dest(a), org(b));
+		splice(e, lnext(a));
+		splice(sym(e), b);
+		return e;
+	}
+
+	static void deleteEdge(QuadEdge *e)
+	{
+		splice(e, oprev(e));
+		splice(sym(e), oprev(sym(e)));
+		e->isDead = sym(e)->isDead = true;
+	}
+
+	double orient(int a, int b, int c) const
+	{
+		return orient2d(_mesh.vertices[a], _mesh.vertices[b], _mesh.vertices[c]);
+	}
+
+	double inCircle(int a, int b, int c, int d) const
+	{
+		PROFILE_COUNT(IncircleTests);
+		return incircle(_mesh.vertices[a], _mesh.vertices[b], _mesh.vertices[c], _mesh.vertices[d]);
+	}
+
+	bool rightOf(int p, QuadEdge *e) const { return orient(p, dest(e), org(e)) > 0; }
+	bool leftOf(int p, QuadEdge *e) const { return orient(p, org(e), dest(e)) > 0; }
+
+	// Triangulates _order[l, r) and returns its counter-clockwise convex hull
+	// edge out of the leftmost vertex and clockwise one out of the rightmost
+	Pair build(int l, int r)
+	{
+		int n = r - l;
+
+		if (n == 2)
+		{
+			QuadEdge *a = makeEdge(_order[l], _order[l + 1]);
+			return Pair(a, sym(a));
+		}
+
+		if (n == 3)
+		{
+			int s1 = _order[l], s2 = _order[l + 1], s3 = _order[l + 2];
+			QuadEdge *a = makeEdge(s1, s2);
+			QuadEdge *b = makeEdge(s2, s3);
+			splice(sym(a), b);
+
+			if (orient(s1, s2, s3) > 0)
+			{
+				connect(b, a);
+				return Pair(a, sym(b));
+			}
+			if (orient(s1, s3, s2) > 0)
+			{
+				QuadEdge *c = connect(b, a);
+				return Pair(sym(c), c);
+			}
+			return Pair(a, sym(b)); // Collinear
+		}
+
+		int m = l + n / 2;
+		Pair left, right;
+
+		if (n > taskCutoff)
+		{
+			#pragma omp task shared(left)
+			left = build(l, m);
+			#pragma omp task shared(right)
+			right = build(m, r);
+			#pragma omp taskwait
+		}
+		else
+		{
+			left = build(l, m);
+			right = build(m, r);
+		}
+
+		return merge(left, right);
+	}
+
+	// Stitches two adjacent triangulations together along the seam
+	Pair merge(Pair left, Pair right)
+	{
+		QuadEdge *ldo = left.first, *ldi = left.second;
+		QuadEdge *rdi = right.first, *rdo = right.second;
+
+		// Find the lower common tangent of the two halves
+		for (;;)
+		{
+			if (leftOf(org(rdi), ldi)) ldi = lnext(ldi);
+			else if (rightOf(org(ldi), rdi)) rdi = rprev(rdi);
+			else break;
+		}
+
+		QuadEdge *basel = connect(sym(rdi), ldi);
+		if (org(ldi) == org(ldo)) ldo = sym(basel);
+		if (org(rdi) == org(rdo)) rdo = basel;
+
+		// Zip the seam upwards, removing edges that are no longer Delaunay
+		for (;;)
+		{
+			QuadEdge *lcand = sym(basel)->onext;
+			bool lvalid = rightOf(dest(lcand), basel);
+			if (lvalid)
+			{
+				while (inCircle(dest(basel), org(basel), dest(lcand), dest(lcand->onext)) > 0)
+				{
+					QuadEdge *t = lcand->onext;
+					deleteEdge(lcand);
+					lcand = t;
+				}
+			}
+
+			QuadEdge *rcand = oprev(basel);
+			bool rvalid = rightOf(dest(rcand), basel);
+			if (rvalid)
+			{
+				while (inCircle(dest(basel), org(basel), dest(rcand), dest(oprev(rcand))) > 0)
+				{
+					QuadEdge *t = oprev(rcand);
+					deleteEdge(rcand);
+					rcand = t;
+				}
+			}
+
+			if (!lvalid && !rvalid) break;
+
+			if (!lvalid || (rvalid && inCircle(dest(lcand), org(lcand), org(rcand), dest(rcand)) > 0))
+				basel = connect(rcand, sym(basel));
+			else
+				basel = connect(sym(basel), sym(lcand));
+		}
+
+		return Pair(ldo, rdo);
+	}
+
+	// Walk every face of the quad-edge structure and keep the triangles
+	void collect()
+	{
+		for (auto pool = begin(_pools); pool != end(_pools); pool++)
+		{
+			for (std::size_t i = 0; i < pool->size(); i++)
+			{
+				Quad *q = &(*pool)[i];
+				if (q->e[0].isDead) continue;
+
+				_mesh.edges.push_back(IndexEdge(q->e[0].origin, q->e[2].origin));
+
+				for (int r = 0; r < 4; r += 2)
+				{
+					QuadEdge *e = &q->e[r];
+					if (e->isUsed) continue;
+
+					QuadEdge *e2 = lnext(e), *e3 = lnext(e2);
+					if (lnext(e3) != e || orient(org(e), org(e2), org(e3)) <= 0) continue;
+
+					e->isUsed = e2->isUsed = e3->isUsed = true;
+					_mesh.triangles.push_back(IndexTriangle(org(e), org(e2), org(e3)));
+				}
+			}
+		}
+	}
+
+	std::vector<int> _order;
+	std::vector<QuadPool> _pools;
+
+	MeshType _mesh;
+	mutable std::vector<TriangleType> _triangles;
+	mutable std::vector<EdgeType> _edges;
+};
+
+#endif
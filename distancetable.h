@@ -0,0 +1,186 @@
+#ifndef H_DISTANCETABLE
+#define H_DISTANCETABLE
+
+#include "vector2.h"
+#include "profile.h"
+
+#include <vector>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DISTANCETABLE_SSE2
+#endif
+
+// Distances between all pairs of a point set, computed once into one
+// contiguous table. Rows are padded to a multiple of 8 floats and aligned
+// to 32 bytes, so the MST of any subset can be evaluated with aligned SIMD
+// loads and without allocating anything per subset.
+class DistanceTable
+{
+public:
+	// Vertices outside the subset are marked with this in a workspace mask
+	static constexpr float excluded = FLT_MAX;
+
+	// Per-thread buffers for mstLength. Fill mask() with 0 for every vertex
+	// of the subset and excluded for the rest.
+	class Workspace
+	{
+	public:
+		Workspace() {}
+		// Copies start empty, the pointers must not share another buffer
+		Workspace(const Workspace &) {}
+		Workspace& operator=(const Workspace &) { return *this; }
+
+		float* mask() { return _mask; }
+
+	private:
+		friend class DistanceTable;
+
+		void reset(std::size_t stride)
+		{
+			if (_stride == stride) return;
+			_stride = stride;
+			_storage.assign(3 * stride + 8, excluded);
+			_mask = align(_storage.data());
+			_blocked = _mask + stride;
+			_key = _blocked + stride;
+		}
+
+		std::vector<float> _storage;
+		std::size_t _stride = 0;
+		float *_mask = nullptr, *_blocked = nullptr, *_key = nullptr;
+	};
+
+	template <class T>
+	void reset(const std::vector<Vector2<T>> &points)
+	{
+		_size = points.size();
+		_stride = (_size + 7) / 8 * 8;
+		_storage.assign(_stride * _size + 8, 0.0f);
+		_data = align(_storage.data());
+
+		for (std::size_t i = 0; i < _size; i++)
+		{
+			float *row = _data + i * _stride;
+			for (std::size_t j = 0; j < _size; j++)
+			{
+				double dx = (double)points[i].x - points[j].x, dy = (double)points[i].y - points[j].y;
+				row[j] = (float)sqrt(dx * dx + dy * dy);
+			}
+		}
+	}
+
+	std::size_t size() const { return _size; }
+	float operator()(std::size_t a, std::size_t b) const { return _data[a * _stride + b]; }
+	const float* row(std::size_t a) const { return _data + a * _stride; }
+
+	// Prepares a workspace for this table, every vertex excluded
+	void prepare(Workspace &w) const
+	{
+		w.reset(_stride);
+		for (std::size_t i = 0; i < _stride; i++) w._mask[i] = excluded;
+	}
+
+	// MST length of the vertices left at 0 in w.mask() (dense Prim)
+	double mstLength(Workspace &w) const
+	{
+		std::size_t count = 0, u = _size;
+		for (std::size_t i = 0; i < _stride; i++)
+		{
+			w._blocked[i] = w._mask[i];
+			w._key[i] = excluded;
+			if (i < _size && w._mask[i] == 0)
+			{
+				if (u == _size) u = i;
+				count++;
+			}
+		}
+
+		PROFILE_ADD(MstRelaxations, count > 1 ? (count - 1) * _stride : 0);
+
+		double summary = 0;
+		for (std::size_t step = 1; step < count; step++)
+		{
+			w._blocked[u] = excluded;
+			w._key[u] = excluded;
+
+			float min;
+			u = update(row(u), w._blocked, w._key, min);
+			summary += min;
+		}
+		return summary;
+	}
+
+private:
+	static float* align(float *p)
+	{
+		return (float*)(((uintptr_t)p + 31) & ~(uintptr_t)31);
+	}
+
+	// key = min(key, row + blocked) over the whole row; returns the vertex
+	// with the smallest key (lowest index on ties) and its key in min
+	std::size_t update(const float *row, const float *blocked, float *key, float &min) const
+	{
+#if defined(__AVX__)
+		__m256 best = _mm256_set1_ps(excluded), bestIndex = _mm256_setzero_ps();
+		__m256 index = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7), step = _mm256_set1_ps(8);
+		for (std::size_t v = 0; v < _stride; v += 8)
+		{
+			__m256 k = _mm256_min_ps(_mm256_load_ps(key + v), _mm256_add_ps(_mm256_load_ps(row + v), _mm256_load_ps(blocked + v)));
+			_mm256_store_ps(key + v, k);
+			__m256 less = _mm256_cmp_ps(k, best, _CMP_LT_OQ);
+			best = _mm256_blendv_ps(best, k, less);
+			bestIndex = _mm256_blendv_ps(bestIndex, index, less);
+			index = _mm256_add_ps(index, step);
+		}
+		const int lanes = 8;
+		alignas(32) float values[8], indices[8];
+		_mm256_store_ps(values, best);
+		_mm256_store_ps(indices, bestIndex);
+#elif defined(DISTANCETABLE_SSE2)
+		__m128 best = _mm_set1_ps(excluded), bestIndex = _mm_setzero_ps();
+		__m128 index = _mm_setr_ps(0, 1, 2, 3), step = _mm_set1_ps(4);
+		for (std::size_t v = 0; v < _stride; v += 4)
+		{
+			__m128 k = _mm_min_ps(_mm_load_ps(key + v), _mm_add_ps(_mm_load_ps(row + v), _mm_load_ps(blocked + v)));
+			_mm_store_ps(key + v, k);
+			__m128 less = _mm_cmplt_ps(k, best);
+			best = _mm_or_ps(_mm_and_ps(less, k), _mm_andnot_ps(less, best));
+			bestIndex = _mm_or_ps(_mm_and_ps(less, index), _mm_andnot_ps(less, bestIndex));
+			index = _mm_add_ps(index, step);
+		}
+		const int lanes = 4;
+		alignas(16) float values[4], indices[4];
+		_mm_store_ps(values, best);
+		_mm_store_ps(indices, bestIndex);
+#else
+		const int lanes = 1;
+		float values[1] = { excluded }, indices[1] = { 0 };
+		for (std::size_t v = 0; v < _stride; v++)
+		{
+			float k = std::min(key[v], row[v] + blocked[v]);
+			key[v] = k;
+			if (k < values[0]) { values[0] = k; indices[0] = (float)v; }
+		}
+#endif
+		// Indices are exact in a float up to 2^24
+		int lane = 0;
+		for (int i = 1; i < lanes; i++)
+			if (values[i] < values[lane] || (values[i] == values[lane] && indices[i] < indices[lane])) lane = i;
+
+		min = values[lane];
+		return (std::size_t)indices[lane];
+	}
+
+	std::vector<float> _storage;
+	float *_data = nullptr;
+	std::size_t _size = 0, _stride = 0;
+};
+
+#endif
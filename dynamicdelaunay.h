@@ -0,0 +1,401 @@
+#ifndef H_DYNAMICDELAUNAY
+#define H_DYNAMICDELAUNAY
+
+#include "vector2.h"
+#include "mesh.h"
+#include "predicates.h"
+#include "arena.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <float.h>
+
+// Delaunay triangulation that stays alive between updates: points can be
+// inserted (Bowyer-Watson cavity, as in Delaunay) and vertices removed (the
+// star of the vertex is re-triangulated by clipping Delaunay ears, after
+// Devillers). Both cost O(degree) on average. After every update
+// getCreated() and getRemoved() list the triangles that changed, so
+// anything derived from the triangles can be updated locally.
+//
+// Vertex 0, 1 and 2 are the corners of a symbolic super triangle (see
+// orient2dSuper): every point the type can hold is inside it.
+template <class T>
+class DynamicDelaunay
+{
+public:
+	using VertexType = Vector2<T>;
+
+	static const int superVertices = 3;
+
+	DynamicDelaunay() { reset(); }
+
+	// Empty triangulation: the super triangle alone
+	void reset()
+	{
+		_points.clear();
+		_alive.clear();
+		_vertexCell.clear();
+		for (int i = 0; i < superVertices; i++) addVertex(VertexType());
+
+		_cells.clear();
+		_free.clear();
+		_cells.push_back(Cell(0, 1, 2));
+		for (int i = 0; i < superVertices; i++) _vertexCell[i] = 0;
+		_last = 0;
+	}
+
+	// Inserts a point and returns its vertex id. A point that is already a
+	// vertex returns that vertex and changes nothing (getCreated() is empty).
+	int insert(const VertexType &point)
+	{
+		_created.clear();
+		_removed.clear();
+
+		int t = locate(point);
+		const Cell &c = _cells[t];
+		for (int k = 0; k < 3; k++)
+			if (c.v[k] >= superVertices && _points[c.v[k]] == point) return c.v[k];
+
+		int p = addVertex(point);
+		insertVertex(t, p);
+		return p;
+	}
+
+	// Removes a vertex inserted before
+	void remove(int vertex)
+	{
+		_created.clear();
+		_removed.clear();
+		if (vertex < superVertices || vertex >= (int)_points.size() || !_alive[vertex]) return;
+
+		_arena.reset();
+		ArenaArray<int> star(_arena), ring(_arena);
+		ArenaArray<Side> sides(_arena);
+
+		// Star of the vertex counter-clockwise. Every triangle (vertex, a, b)
+		// gives the ring edge a -> b and the triangle beyond it.
+		int t = _vertexCell[vertex];
+		do
+		{
+			const Cell &c = _cells[t];
+			int i = c.v[0] == vertex ? 0 : c.v[1] == vertex ? 1 : 2;
+			star.push_back(t);
+			ring.push_back(c.v[(i + 1) % 3]);
+			sides.push_back(Side(c.n[(i + 1) % 3], t, -1));
+			t = c.n[(i + 2) % 3];
+		} while (t != star[0]);
+
+		// Clip ears until one triangle is left. An ear (a, b, c) is convex and
+		// no other ring vertex lies inside its circumcircle.
+		ArenaArray<int> next(_arena);
+		for (std::size_t i = 0; i < ring.size(); i++) next.push_back((int)((i + 1) % ring.size()));
+
+		int a = 0;
+		std::size_t left = ring.size(), tried = 0;
+		while (left > 3)
+		{
+			int b = next[a], c = next[b];
+			bool ear = orient(ring[a], ring[b], ring[c]) > 0;
+			for (int d = next[c]; ear && d != a; d = next[d])
+				ear = inCircle(ring[a], ring[b], ring[c], ring[d]) <= 0;
+
+			if (!ear && ++tried < left)
+			{
+				a = b;
+				continue;
+			}
+
+			// No ear in a whole round, the ring is degenerate (collinear or
+			// cocircular vertices): the convex corner whose circumcircle the
+			// other ring vertices violate least. Never a flat or reflex one,
+			// that would fold the triangulation.
+			if (!ear)
+			{
+				int best = -1;
+				double least = DBL_MAX;
+				for (std::size_t k = 0; k < left; k++, a = next[a])
+				{
+					int pa = ring[a], pb = ring[next[a]], pc = ring[next[next[a]]];
+					if (orient(pa, pb, pc) <= 0) continue;
+
+					double violation = -DBL_MAX;
+					for (int d = next[next[next[a]]]; d != a; d = next[d])
+						violation = std::max(violation, inCircle(pa, pb, pc, ring[d]));
+					if (violation < least)
+					{
+						least = violation;
+						best = a;
+					}
+				}
+				if (best < 0) throw "Vertex star without a convex corner";
+
+				a = best;
+				b = next[a];
+				c = next[b];
+			}
+
+			// The rest of the ring now ends at the edge c -> a of the ear
+			int id = addTriangle(ring[a], ring[b], ring[c], sides[a], sides[b]);
+			sides[a] = Side(-1, -1, id);
+			sides[a].edge = 2;
+			next[a] = c;
+			left--;
+			tried = 0;
+		}
+
+		int b = next[a], c = next[b];
+		int id = addTriangle(ring[a], ring[b], ring[c], sides[a], sides[b]);
+		connect(id, 2, sides[c]);
+
+		for (auto s = begin(star); s != end(star); s++)
+			releaseCell(*s);
+
+		_alive[vertex] = 0;
+	}
+
+	// Triangles added and taken away by the last update
+	const std::vector<int>& getCreated() const { return _created; }
+	const std::vector<int>& getRemoved() const { return _removed; }
+
+	// Triangle slots: getCell(i) is valid while isCell(i)
+	std::size_t cellCount() const { return _cells.size(); }
+	bool isCell(int i) const { return i >= 0 && i < (int)_cells.size() && !_cells[i].isDead; }
+	const int* getCell(int i) const { return _cells[i].v; }
+	// Triangle across the edge from vertex k to k + 1, -1 on the hull
+	int getNeighbour(int i, int k) const { return _cells[i].n[k]; }
+	// Triangle between input points only, not touching the super triangle
+	bool isInner(int i) const
+	{
+		const int *v = _cells[i].v;
+		return v[0] >= superVertices && v[1] >= superVertices && v[2] >= superVertices;
+	}
+
+	const std::vector<VertexType>& getPoints() const { return _points; }
+	bool isVertex(int v) const { return v >= superVertices && v < (int)_points.size() && _alive[v]; }
+
+	// Inner triangles and their edges, indices into getPoints()
+	void getMesh(Mesh<T> &mesh) const
+	{
+		mesh.clear();
+		mesh.vertices = _points;
+		for (int i = 0; i < (int)_cells.size(); i++)
+		{
+			if (_cells[i].isDead || !isInner(i)) continue;
+			const Cell &t = _cells[i];
+			mesh.triangles.push_back(IndexTriangle(t.v[0], t.v[1], t.v[2]));
+			for (int k = 0; k < 3; k++)
+			{
+				int a = t.v[k], b = t.v[(k + 1) % 3], nb = t.n[k];
+				if (a < b || nb < 0 || !isInner(nb))
+					mesh.edges.push_back(IndexEdge(a, b));
+			}
+		}
+	}
+
+private:
+	// As in Delaunay: n[i] lies across the edge v[i] -> v[i + 1]
+	struct Cell
+	{
+		Cell(int a, int b, int c) { set(a, b, c); }
+
+		void set(int a, int b, int c)
+		{
+			v[0] = a; v[1] = b; v[2] = c;
+			n[0] = n[1] = n[2] = -1;
+			isBad = isDead = false;
+		}
+
+		int v[3];
+		int n[3];
+		bool isBad;
+		bool isDead;
+	};
+
+	// What lies beyond an edge of a hole: either an old triangle (outer,
+	// pointing back at inner) or edge 'edge' of a new triangle 'cell'
+	struct Side
+	{
+		Side() {}
+		Side(int outer, int inner, int cell) : outer(outer), inner(inner), cell(cell), edge(0) {}
+
+		int outer, inner;
+		int cell, edge;
+	};
+
+	int addVertex(const VertexType &point)
+	{
+		_points.push_back(point);
+		_alive.push_back(1);
+		_vertexCell.push_back(-1);
+		return (int)_points.size() - 1;
+	}
+
+	int allocateCell(int a, int b, int c)
+	{
+		int id;
+		if (_free.empty())
+		{
+			id = (int)_cells.size();
+			_cells.push_back(Cell(a, b, c));
+		}
+		else
+		{
+			id = _free.back();
+			_free.pop_back();
+			_cells[id].set(a, b, c);
+		}
+
+		_vertexCell[a] = _vertexCell[b] = _vertexCell[c] = id;
+		_created.push_back(id);
+		_last = id;
+		return id;
+	}
+
+	void releaseCell(int id)
+	{
+		_cells[id].isDead = true;
+		_free.push_back(id);
+		_removed.push_back(id);
+	}
+
+	// Edge k of triangle id faces the given side of the hole
+	void connect(int id, int k, const Side &side)
+	{
+		if (side.cell >= 0)
+		{
+			_cells[id].n[k] = side.cell;
+			_cells[side.cell].n[side.edge] = id;
+			return;
+		}
+
+		_cells[id].n[k] = side.outer;
+		if (side.outer >= 0)
+		{
+			Cell &outer = _cells[side.outer];
+			for (int m = 0; m < 3; m++)
+				if (outer.n[m] == side.inner) outer.n[m] = id;
+		}
+	}
+
+	int addTriangle(int a, int b, int c, const Side &ab, const Side &bc)
+	{
+		int id = allocateCell(a, b, c);
+		connect(id, 0, ab);
+		connect(id, 1, bc);
+		return id;
+	}
+
+	// Predicates on vertex ids, the super triangle corners symbolic
+	static int corner(int v) { return v < superVertices ? v : -1; }
+
+	double orient(int a, int b, int c) const
+	{
+		return orient2dSuper(_points[a], corner(a), _points[b], corner(b), _points[c], corner(c));
+	}
+
+	double inCircle(int a, int b, int c, int d) const
+	{
+		return incircleSuper(_points[a], corner(a), _points[b], corner(b), _points[c], corner(c), _points[d], corner(d));
+	}
+
+	// Bowyer-Watson insertion of vertex p into triangle t
+	void insertVertex(int t, int p)
+	{
+		_arena.reset();
+		ArenaArray<int> cavity(_arena), fan(_arena);
+		ArenaArray<Side> polygon(_arena);
+		ArenaArray<int> starts(_arena);
+
+		cavity.push_back(t);
+		_cells[t].isBad = true;
+		for (std::size_t i = 0; i < cavity.size(); i++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				int nb = _cells[cavity[i]].n[k];
+				if (nb < 0 || _cells[nb].isBad) continue;
+
+				const int *v = _cells[nb].v;
+				if (inCircle(v[0], v[1], v[2], p) > 0)
+				{
+					_cells[nb].isBad = true;
+					cavity.push_back(nb);
+				}
+			}
+		}
+
+		for (auto b = begin(cavity); b != end(cavity); b++)
+		{
+			for (int k = 0; k < 3; k++)
+			{
+				int nb = _cells[*b].n[k];
+				if (nb < 0 || !_cells[nb].isBad)
+				{
+					polygon.push_back(Side(nb, *b, -1));
+					starts.push_back(_cells[*b].v[k]);
+					starts.push_back(_cells[*b].v[(k + 1) % 3]);
+				}
+			}
+		}
+
+		// New triangles reuse slots freed before, never the cavity's own
+		if (_fanStart.size() < _points.size()) _fanStart.resize(_points.size());
+		for (std::size_t e = 0; e < polygon.size(); e++)
+		{
+			int id = allocateCell(starts[2 * e], starts[2 * e + 1], p);
+			connect(id, 0, polygon[e]);
+			_fanStart[starts[2 * e]] = id;
+			fan.push_back(id);
+		}
+
+		for (auto b = begin(cavity); b != end(cavity); b++)
+			releaseCell(*b);
+
+		for (auto i = begin(fan); i != end(fan); i++)
+		{
+			int j = _fanStart[_cells[*i].v[1]];
+			_cells[*i].n[1] = j;
+			_cells[j].n[2] = *i;
+		}
+	}
+
+	// Visibility walk from the last new triangle. _last is always alive:
+	// every update allocates its new triangles before it frees the old ones.
+	int locate(const VertexType &v)
+	{
+		int t = _last;
+
+		for (;;)
+		{
+			const Cell &c = _cells[t];
+			int next = -1;
+
+			unsigned int k0 = (_seed = _seed * 1103515245u + 12345u) >> 16;
+			for (int i = 0; i < 3 && next < 0; i++)
+			{
+				int k = (int)((k0 + i) % 3);
+				int a = c.v[k], b = c.v[(k + 1) % 3];
+				if (orient2dSuper(_points[a], corner(a), _points[b], corner(b), v, -1) < 0)
+					next = c.n[k];
+			}
+
+			if (next < 0) return t;
+			t = next;
+		}
+	}
+
+	std::vector<VertexType> _points;
+	std::vector<char> _alive;
+	std::vector<int> _vertexCell;	// Some triangle around each vertex
+
+	std::vector<Cell> _cells;
+	std::vector<int> _free;
+	std::vector<int> _fanStart;
+	std::vector<int> _created, _removed;
+	int _last = 0;
+	unsigned int _seed = 1;
+	Arena _arena;
+};
+
+#endif
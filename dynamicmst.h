@@ -0,0 +1,381 @@
+#ifndef H_DYNAMICMST
+#define H_DYNAMICMST
+
+#include "vector2.h"
+#include "mesh.h"
+#include "distancetable.h"
+#include "profile.h"
+
+#include <vector>
+#include <algorithm>
+#include <float.h>
+#include <stdint.h>
+#include <omp.h>
+
+// Minimum spanning tree over a changing subset of a fixed point set. The
+// first 'terminals' points are always in the tree, any other point can be
+// inserted or removed with a local update:
+//  - insert is O(n) (Chin & Houck): the tree plus a star from the new point
+//    is reduced to a tree in one walk up from the leaves;
+//  - remove is O(n * s), s being the number of vertices outside the largest
+//    piece left behind; only those pieces are reconnected.
+template <class T>
+class DynamicMST
+{
+public:
+	using VertexType = Vector2<T>;
+
+	// Tree over the terminals only (dense Prim, done once). The table is
+	// shared, not copied, and must outlive the tree.
+	void reset(const DistanceTable &table, std::size_t terminals)
+	{
+		const std::size_t n = table.size();
+		_table = &table;
+		_terminals = std::min(terminals, n);
+
+		// Grows only and is emptied, not freed, so a tree reset for every net
+		// (or copied from one that is) keeps its lists; _active holds n
+		if (_adjacency.size() < n) _adjacency.resize(n);
+		for (auto a = begin(_adjacency); a != end(_adjacency); a++) a->clear();
+		_active.assign(n, 0);
+		_parent.assign(n, 0);
+		_component.assign(n, 0);
+		_heaviest.assign(n, Edge());
+		_star.assign(n, 0);
+		_key.assign(n, DBL_MAX);
+		_from.assign(n, 0);
+		_length = 0;
+		_count = _terminals;
+		_root = 0;
+
+		for (std::size_t i = 0; i < _terminals; i++) _active[i] = 1;
+		if (_terminals < 2) return;
+
+		for (std::size_t i = 1; i < _terminals; i++) _key[i] = distance(0, (uint32_t)i);
+		_inTree.assign(_terminals, 0);
+		_inTree[0] = 1;
+		for (std::size_t count = 1; count < _terminals; count++)
+		{
+			uint32_t next = 0;
+			double min = DBL_MAX;
+			for (uint32_t v = 0; v < _terminals; v++)
+				if (!_inTree[v] && _key[v] < min) { min = _key[v]; next = v; }
+
+			_inTree[next] = 1;
+			link(_from[next], next);
+			_length += min;
+
+			for (uint32_t v = 0; v < _terminals; v++)
+			{
+				double d = distance(next, v);
+				if (!_inTree[v] && d < _key[v]) { _key[v] = d; _from[v] = next; }
+			}
+		}
+	}
+
+	void insert(uint32_t z)
+	{
+		if (_active[z]) return;
+		PROFILE_COUNT(DynamicInserts);
+		_active[z] = 1;
+		if (_count++ == 0)
+		{
+			_root = z;
+			return;
+		}
+
+		// Tree in depth-first order, parents before children
+		_order.clear();
+		_stack.assign(1, _root);
+		_parent[_root] = _root;
+		while (!_stack.empty())
+		{
+			uint32_t u = _stack.back();
+			_stack.pop_back();
+			_order.push_back(u);
+			for (auto v = begin(_adjacency[u]); v != end(_adjacency[u]); v++)
+				if (*v != _parent[u]) { _parent[*v] = u; _stack.push_back(*v); }
+		}
+
+		// Add the star (z, u) for every u. Merging a child u into its parent p
+		// closes one cycle: the edge (p, u), the heaviest edge on the path from
+		// u to z, and the heaviest on the path from p to z. The heaviest of the
+		// three goes.
+		for (auto u = begin(_order); u != end(_order); u++)
+		{
+			_heaviest[*u] = Edge(z, *u, distance(z, *u));
+			_star[*u] = 1;
+		}
+
+		_dropped.clear();
+		for (std::size_t i = _order.size() - 1; i > 0; i--)
+		{
+			uint32_t u = _order[i], p = _parent[u];
+			Edge a(p, u, distance(p, u));
+			const Edge &b = _heaviest[u];
+			Edge &h = _heaviest[p];
+
+			if (h.w >= a.w && h.w >= b.w)
+			{
+				drop(h, z);
+				h = a.w > b.w ? a : b;
+			}
+			else if (a.w >= b.w)
+				drop(a, z);
+			else
+				drop(b, z);
+		}
+
+		for (auto e = begin(_dropped); e != end(_dropped); e++) unlink(e->a, e->b);
+		for (auto u = begin(_order); u != end(_order); u++)
+		{
+			if (!_star[*u]) continue;
+			link(z, *u);
+			_length += distance(z, *u);
+		}
+	}
+
+	void remove(uint32_t z)
+	{
+		if (!_active[z] || z < _terminals) return;
+		PROFILE_COUNT(DynamicRemoves);
+		_active[z] = 0;
+		_count--;
+
+		_neighbours = _adjacency[z];
+		for (auto v = begin(_neighbours); v != end(_neighbours); v++)
+		{
+			_length -= distance(z, *v);
+			unlink(z, *v);
+		}
+		if (_root == z && !_neighbours.empty()) _root = _neighbours[0];
+		if (_neighbours.size() < 2) return;
+
+		// Pieces left behind, their vertices stored one piece after another
+		_members.clear();
+		_first.clear();
+		std::size_t largest = 0, largestSize = 0;
+		for (std::size_t c = 0; c < _neighbours.size(); c++)
+		{
+			uint32_t start = _neighbours[c];
+			_first.push_back(_members.size());
+			_members.push_back(start);
+			_parent[start] = start;
+			for (std::size_t i = _first.back(); i < _members.size(); i++)
+			{
+				uint32_t u = _members[i];
+				_component[u] = (uint32_t)c;
+				for (auto v = begin(_adjacency[u]); v != end(_adjacency[u]); v++)
+					if (*v != _parent[u]) { _parent[*v] = u; _members.push_back(*v); }
+			}
+			std::size_t size = _members.size() - _first.back();
+			if (size > largestSize) { largestSize = size; largest = c; }
+		}
+		_first.push_back(_members.size());
+
+		// The tree edges are still minimal, the pieces are joined by Prim over
+		// the pieces, starting from the largest one: only the vertices of the
+		// other pieces carry a key.
+		_small.clear();
+		_joined.assign(_neighbours.size(), 0);
+		_joined[largest] = 1;
+		for (std::size_t c = 0; c < _neighbours.size(); c++)
+			if (c != largest)
+				_small.insert(end(_small), begin(_members) + _first[c], begin(_members) + _first[c + 1]);
+
+		for (auto s = begin(_small); s != end(_small); s++) _key[*s] = DBL_MAX;
+		relax(largest);
+
+		for (std::size_t step = 1; step < _neighbours.size(); step++)
+		{
+			uint32_t next = 0;
+			double min = DBL_MAX;
+			for (auto s = begin(_small); s != end(_small); s++)
+				if (!_joined[_component[*s]] && _key[*s] < min) { min = _key[*s]; next = *s; }
+
+			link(_from[next], next);
+			_length += min;
+
+			_joined[_component[next]] = 1;
+			relax(_component[next]);
+		}
+	}
+
+	bool contains(uint32_t v) const { return _active[v] != 0; }
+	double length() const { return _length; }
+
+	// Edges of the current tree, indices into the point set given to reset()
+	void getTree(std::vector<IndexEdge> &tree) const
+	{
+		tree.clear();
+		for (uint32_t a = 0; a < _active.size(); a++)
+			for (auto b = begin(_adjacency[a]); b != end(_adjacency[a]); b++)
+				if (a < *b) tree.push_back(IndexEdge(a, *b));
+	}
+
+private:
+	struct Edge
+	{
+		Edge() {}
+		Edge(uint32_t a, uint32_t b, double w) : a(a), b(b), w(w) {}
+		uint32_t a = 0, b = 0;
+		double w = 0;
+	};
+
+	double distance(uint32_t a, uint32_t b) const { return (*_table)(a, b); }
+
+	void link(uint32_t a, uint32_t b)
+	{
+		_adjacency[a].push_back(b);
+		_adjacency[b].push_back(a);
+	}
+
+	void unlink(uint32_t a, uint32_t b)
+	{
+		std::vector<uint32_t> &x = _adjacency[a], &y = _adjacency[b];
+		x.erase(std::find(begin(x), end(x), b));
+		y.erase(std::find(begin(y), end(y), a));
+	}
+
+	// Star edges are (z, u), everything else is a tree edge
+	void drop(const Edge &e, uint32_t z)
+	{
+		if (e.a == z)
+			_star[e.b] = 0;
+		else
+		{
+			_dropped.push_back(e);
+			_length -= e.w;
+		}
+	}
+
+	// Keys of the pieces not joined yet against the vertices of piece c
+	void relax(std::size_t c)
+	{
+		for (std::size_t i = _first[c]; i < _first[c + 1]; i++)
+		{
+			uint32_t w = _members[i];
+			for (auto s = begin(_small); s != end(_small); s++)
+			{
+				if (_joined[_component[*s]]) continue;
+				double d = distance(w, *s);
+				if (d < _key[*s]) { _key[*s] = d; _from[*s] = w; }
+			}
+		}
+	}
+
+	const DistanceTable *_table = nullptr;
+	std::size_t _terminals = 0;
+	std::vector<std::vector<uint32_t>> _adjacency;
+	std::vector<char> _active;
+	std::size_t _count = 0;
+	uint32_t _root = 0;
+	double _length = 0;
+
+	// Scratch
+	std::vector<uint32_t> _parent, _order, _stack, _neighbours;
+	std::vector<Edge> _heaviest, _dropped;
+	std::vector<char> _star, _joined, _inTree;
+	std::vector<uint32_t> _component, _members, _small, _from;
+	std::vector<std::size_t> _first;
+	std::vector<double> _key;
+};
+
+// Exhaustive search over all 2^k subsets of the candidates in Gray-code
+// order: consecutive subsets differ by one candidate, so each step is one
+// DynamicMST update instead of an O(n^2) rebuild. The high bits are split
+// into blocks that threads walk independently.
+template <class T>
+class GrayCodeSteiner
+{
+public:
+	using VertexType = Vector2<T>;
+
+	// Largest candidate set a bitmask can hold
+	static const std::size_t maxCandidates = 64;
+
+	// Returns the best subset as a bitmask (bit i = candidates[i])
+	uint64_t solve(const std::vector<VertexType> &terminals, const std::vector<VertexType> &candidates)
+	{
+		PROFILE_SCOPE("GrayCodeSteiner::solve");
+
+		const std::size_t k = std::min(candidates.size(), maxCandidates);
+		const uint32_t t = (uint32_t)terminals.size();
+
+		_points.assign(begin(terminals), end(terminals));
+		_points.insert(end(_points), begin(candidates), begin(candidates) + k);
+
+		// Shared by all threads, each block only keeps its own tree
+		_table.reset(_points);
+		_base.reset(_table, t);
+
+		// A few blocks per thread, but never more than half of the bits
+		int high = 0;
+		while (((uint64_t)1 << high) < 4 * (uint64_t)omp_get_max_threads() && high < (int)k / 2) high++;
+		const int low = (int)k - high;
+		const int64_t blocks = (int64_t)1 << high;
+
+		double best = DBL_MAX;
+		uint64_t bestMask = 0;
+
+		#pragma omp parallel
+		{
+			// Trees kept between calls, copying the base reuses their buffers
+			#pragma omp single
+			if (_trees.size() < (std::size_t)omp_get_num_threads()) _trees.resize(omp_get_num_threads());
+
+			DynamicMST<T> &tree = _trees[omp_get_thread_num()];
+			double threadBest = DBL_MAX;
+			uint64_t threadMask = 0;
+
+			#pragma omp for schedule(dynamic)
+			for (int64_t b = 0; b < blocks; b++)
+			{
+				tree = _base;
+				uint64_t current = (uint64_t)b << low;
+				for (int j = low; j < (int)k; j++)
+					if (current >> j & 1) tree.insert(t + j);
+
+				if (tree.length() < threadBest) { threadBest = tree.length(); threadMask = current; }
+
+				for (uint64_t i = 1; i < ((uint64_t)1 << low); i++)
+				{
+					// Gray code: flip the lowest set bit of the step counter
+					int j = 0;
+					while (!(i >> j & 1)) j++;
+
+					current ^= (uint64_t)1 << j;
+					if (current >> j & 1) tree.insert(t + j);
+					else tree.remove(t + j);
+
+					if (tree.length() < threadBest) { threadBest = tree.length(); threadMask = current; }
+				}
+			}
+
+			#pragma omp critical
+			{
+				if (threadBest < best || (threadBest == best && threadMask < bestMask))
+				{
+					best = threadBest;
+					bestMask = threadMask;
+				}
+			}
+		}
+
+		PROFILE_ADD(SubsetsEvaluated, (uint64_t)blocks << low);
+
+		_length = best;
+		return bestMask;
+	}
+
+	float getLength() const { return (float)_length; }
+
+private:
+	DistanceTable _table;
+	std::vector<VertexType> _points;
+	DynamicMST<T> _base;
+	std::vector<DynamicMST<T>> _trees;	// One per thread
+	double _length = 0;
+};
+
+#endif
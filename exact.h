@@ -0,0 +1,187 @@
+#ifndef H_EXACT
+#define H_EXACT
+
+#include "vector2.h"
+#include "distancetable.h"
+#include "profile.h"
+
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <omp.h>
+
+// Exact search for the subset of Steiner candidates whose MST together with
+// the terminals is shortest. Subsets are enumerated as a binomial tree (every
+// node adds one candidate with a larger index than the ones it already has),
+// so each subset is scored exactly once. Subtrees are split across threads as
+// OpenMP tasks, which the runtime balances by stealing. All threads share the
+// best length found so far and cut every subtree whose lower bound already
+// exceeds it; besides the recursion, only O(threads) state is kept.
+template <class T>
+class ExactSteiner
+{
+public:
+	using VertexType = Vector2<T>;
+
+	// Proven lower bound on SMT / MST (Chung & Graham, 1985). Any tree spanning
+	// a superset of P is a Steiner tree of P, so no subtree below a subset whose
+	// MST is L can be shorter than steinerRatio * L.
+	static constexpr double steinerRatio = 0.824;
+
+	// Largest candidate set a bitmask can hold
+	static const std::size_t maxCandidates = 64;
+
+	// The search stops at the deadline, solve() then returns the best subset
+	// seen so far and isComplete() is false
+	void setDeadline(std::chrono::steady_clock::time_point deadline) { _deadline = deadline; }
+	bool isComplete() const { return !_stop.load(); }
+
+	// Returns the best subset as a bitmask (bit i = candidates[i]). A known
+	// subset, e.g. from the greedy mode, can be passed in as the first incumbent.
+	uint64_t solve(const std::vector<VertexType> &terminals, const std::vector<VertexType> &candidates, uint64_t initial = 0)
+	{
+		PROFILE_SCOPE("ExactSteiner::solve");
+
+		const std::size_t k = std::min(candidates.size(), maxCandidates);
+		_terminals = terminals.size();
+
+		// One distance table for terminals and candidates, shared by all threads
+		std::vector<VertexType> points(begin(terminals), end(terminals));
+		points.insert(end(points), begin(candidates), begin(candidates) + k);
+		_table.reset(points);
+
+		// Try the most promising candidates first, the incumbent drops sooner
+		_order.resize(k);
+		for (std::size_t i = 0; i < k; i++) _order[i] = (int)i;
+
+		_scratch.assign(1, Scratch());
+		_table.prepare(_scratch[0].workspace);
+		double base = evaluate(0, _scratch[0]);
+		std::vector<std::pair<double, int>> gain;
+		for (std::size_t i = 0; i < k; i++)
+			gain.push_back(std::make_pair(evaluate((uint64_t)1 << i, _scratch[0]) - base, (int)i));
+		std::sort(begin(gain), end(gain));
+
+		for (std::size_t i = 0; i < k; i++) _order[i] = gain[i].second;
+
+		// Incumbent
+		uint64_t start = 0;
+		for (std::size_t i = 0; i < k; i++)
+			if (initial >> _order[i] & 1) start |= (uint64_t)1 << i;
+
+		_scratch.assign(omp_get_max_threads(), Scratch());
+		for (auto sc = begin(_scratch); sc != end(_scratch); sc++) _table.prepare(sc->workspace);
+		double best = std::min(base, evaluate(start, _scratch[0]));
+		_best.store(best);
+		_bestMask = best < base ? start : 0;
+		_evaluated = 0;
+		_pruned = 0;
+		_stop.store(false);
+
+		#pragma omp parallel
+		#pragma omp single
+		search(0, 0, 0);
+
+		// Best subset over all threads, bits mapped back to the input order
+		uint64_t mask = _bestMask;
+		for (auto s = begin(_scratch); s != end(_scratch); s++)
+		{
+			if (s->best < best) { best = s->best; mask = s->mask; }
+			_evaluated += s->evaluated;
+			_pruned += s->pruned;
+			PROFILE_ADD(SubsetsEvaluated, s->evaluated);
+			PROFILE_ADD(SubsetsPruned, s->pruned);
+		}
+
+		_length = best;
+		uint64_t result = 0;
+		for (std::size_t i = 0; i < k; i++)
+			if (mask >> i & 1) result |= (uint64_t)1 << _order[i];
+		return result;
+	}
+
+	float getLength() const { return (float)_length; }
+	uint64_t getEvaluated() const { return _evaluated; }
+	uint64_t getPruned() const { return _pruned; }
+
+private:
+	// Per-thread state: MST buffers and the best subset this thread has seen
+	struct Scratch
+	{
+		DistanceTable::Workspace workspace;
+		double best = DBL_MAX;
+		uint64_t mask = 0;
+		uint64_t evaluated = 0;
+		uint64_t pruned = 0;
+	};
+
+	// Subtrees this deep or shallower become tasks
+	static const int taskDepth = 8;
+
+	// MST length of the terminals plus the candidates in mask, bit i being
+	// the candidate at position i of _order
+	double evaluate(uint64_t mask, Scratch &s) const
+	{
+		float *active = s.workspace.mask();
+		for (std::size_t i = 0; i < _terminals; i++) active[i] = 0;
+		for (std::size_t i = 0; i < _order.size(); i++)
+			active[_terminals + _order[i]] = (mask >> i & 1) ? 0 : DistanceTable::excluded;
+
+		return _table.mstLength(s.workspace);
+	}
+
+	void search(uint64_t mask, int next, int depth)
+	{
+		Scratch &s = _scratch[omp_get_thread_num()];
+
+		for (int i = next; i < (int)_order.size(); i++)
+		{
+			if (s.evaluated % 256 == 0 && std::chrono::steady_clock::now() > _deadline) _stop.store(true);
+			if (_stop.load(std::memory_order_relaxed)) return;
+
+			uint64_t child = mask | (uint64_t)1 << i;
+			double value = evaluate(child, s);
+			s.evaluated++;
+
+			double best = _best.load(std::memory_order_relaxed);
+			while (value < best && !_best.compare_exchange_weak(best, value)) {}
+			if (value < s.best) { s.best = value; s.mask = child; }
+
+			// No superset of child can beat the incumbent
+			if (steinerRatio * value >= _best.load(std::memory_order_relaxed))
+			{
+				s.pruned++;
+				continue;
+			}
+
+			if (i + 1 == (int)_order.size()) continue;
+
+			if (depth < taskDepth)
+			{
+				#pragma omp task firstprivate(child, i, depth)
+				search(child, i + 1, depth + 1);
+			}
+			else
+				search(child, i + 1, depth + 1);
+		}
+	}
+
+	std::size_t _terminals = 0;
+	std::vector<int> _order;
+	DistanceTable _table;
+	std::vector<Scratch> _scratch;
+
+	std::atomic<double> _best;
+	std::atomic<bool> _stop{false};
+	std::chrono::steady_clock::time_point _deadline = std::chrono::steady_clock::time_point::max();
+	uint64_t _bestMask = 0;
+	double _length = 0;
+	uint64_t _evaluated = 0;
+	uint64_t _pruned = 0;
+};
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef H_FERMAT
+#define H_FERMAT
+
+#include "vector2.h"
+
+#include <vector>
+#include <math.h>
+#include <stdint.h>
+
+// Triangles in structure-of-arrays form, one array per coordinate
+template <class T>
+struct TriangleBatch
+{
+	void clear() { resize(0); }
+
+	void resize(std::size_t count)
+	{
+		ax.resize(count); ay.resize(count);
+		bx.resize(count); by.resize(count);
+		cx.resize(count); cy.resize(count);
+	}
+
+	void set(std::size_t i, const Vector2<T> &a, const Vector2<T> &b, const Vector2<T> &c)
+	{
+		ax[i] = a.x; ay[i] = a.y;
+		bx[i] = b.x; by[i] = b.y;
+		cx[i] = c.x; cy[i] = c.y;
+	}
+
+	std::size_t size() const { return ax.size(); }
+
+	std::vector<T> ax, ay, bx, by, cx, cy;
+};
+
+// What fermatPoints found for a triangle
+enum FermatOutcome : uint8_t
+{
+	FermatWide = 0,			// An angle >= 120 degrees, the Fermat point is that vertex
+	FermatPoint = 1,		// x and y hold the Fermat point
+	FermatDegenerate = 2	// Collinear or coincident vertices
+};
+
+// Fermat (Torricelli) point of every triangle in [first, last) of the batch.
+// The point lies on the line from each vertex to the apex of the equilateral
+// triangle built outwards on the opposite side, so it is the intersection of
+// two such lines. A triangle with an angle >= 120 degrees (cos <= -1/2,
+// tested on dot products, no acos) has its Fermat point at that vertex.
+// outcome[i] tells which case a triangle is (FermatOutcome). Branch-free,
+// the loop runs in SIMD lanes. Integer coordinate types get the point
+// rounded to the grid.
+template <class T>
+void fermatPoints(const TriangleBatch<T> &batch, std::size_t first, std::size_t last, T *x, T *y, uint8_t *outcome)
+{
+	const T *ax = batch.ax.data(), *ay = batch.ay.data();
+	const T *bx = batch.bx.data(), *by = batch.by.data();
+	const T *cx = batch.cx.data(), *cy = batch.cy.data();
+	const double h = 0.86602540378443864676; // sqrt(3) / 2
+
+	#pragma omp simd
+	for (std::ptrdiff_t i = (std::ptrdiff_t)first; i < (std::ptrdiff_t)last; i++)
+	{
+		// Relative to a, that keeps the products small
+		double ox = ax[i], oy = ay[i];
+		double ux = bx[i] - ox, uy = by[i] - oy;	// b - a
+		double vx = cx[i] - ox, vy = cy[i] - oy;	// c - a
+		double wx = vx - ux, wy = vy - uy;			// c - b
+
+		double uu = ux * ux + uy * uy, vv = vx * vx + vy * vy, ww = wx * wx + wy * wy;
+
+		// Angle >= 120 degrees at a vertex: dot <= 0 and 4 dot^2 >= |e1|^2 |e2|^2
+		double da = ux * vx + uy * vy;
+		double db = -ux * wx - uy * wy;
+		double dc = vx * wx + vy * wy;
+		bool wide = (da <= 0 && 4 * da * da >= uu * vv)
+			|| (db <= 0 && 4 * db * db >= uu * ww)
+			|| (dc <= 0 && 4 * dc * dc >= vv * ww);
+
+		// Outwards is to the right of an edge for a counter-clockwise triangle
+		double orient = ux * vy - uy * vx;
+		double s = orient > 0 ? h : -h;
+
+		// Apex on bc (opposite a) and on ca (opposite b)
+		double pX = (ux + vx) * 0.5 + s * wy, pY = (uy + vy) * 0.5 - s * wx;
+		double qX = vx * 0.5 - s * vy, qY = vy * 0.5 + s * vx;
+
+		// a + t * p = b + r * (q - b)
+		double rx = qX - ux, ry = qY - uy;
+		double denominator = pX * ry - pY * rx;
+		double t = (ux * ry - uy * rx) / (denominator != 0 ? denominator : 1);
+
+		// Collinear corners also pass the angle test, they are told apart first
+		bool degenerate = orient == 0 || denominator == 0;
+		x[i] = toCoordinate<T>(ox + t * pX);
+		y[i] = toCoordinate<T>(oy + t * pY);
+		outcome[i] = degenerate ? FermatDegenerate : wide ? FermatWide : FermatPoint;
+	}
+}
+
+template <class T>
+void fermatPoints(const TriangleBatch<T> &batch, T *x, T *y, uint8_t *outcome)
+{
+	fermatPoints(batch, 0, batch.size(), x, y, outcome);
+}
+
+#endif
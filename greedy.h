@@ -0,0 +1,372 @@
+#ifndef H_GREEDY
+#define H_GREEDY
+
+#include "vector2.h"
+#include "mesh.h"
+#include "mst.h"
+#include "profile.h"
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <chrono>
+
+// Uniform bucket grid for k-nearest queries over a changing point set
+template <class T>
+class PointGrid
+{
+public:
+	using VertexType = Vector2<T>;
+
+	void reset(double minX, double minY, double maxX, double maxY, std::size_t expected)
+	{
+		// About two points per cell
+		double w = std::max(maxX - minX, 1e-9), h = std::max(maxY - minY, 1e-9);
+		_cell = std::max(sqrt(w * h * 2.0 / std::max<std::size_t>(expected, 1)), 1e-9);
+		_nx = std::min(std::max((int)(w / _cell) + 1, 1), 4096);
+		_ny = std::min(std::max((int)(h / _cell) + 1, 1), 4096);
+		_cell = std::max(w / (_nx - 0.5), h / (_ny - 0.5));
+		_minX = minX; _minY = minY;
+
+		// Cells past the current grid are kept for later, larger grids
+		const std::size_t cells = (std::size_t)_nx * _ny;
+		if (_cells.size() < cells) _cells.resize(cells);
+		for (std::size_t c = 0; c < cells; c++) _cells[c].clear();
+	}
+
+	void insert(uint32_t id, const VertexType &p) { _cells[cellOf(p)].push_back(id); }
+
+	void remove(uint32_t id, const VertexType &p)
+	{
+		std::vector<uint32_t> &c = _cells[cellOf(p)];
+		c.erase(std::find(begin(c), end(c), id));
+	}
+
+	// Up to k nearest stored points, closest first
+	void nearest(const VertexType &p, int k, const std::vector<VertexType> &points, std::vector<uint32_t> &out)
+	{
+		out.clear();
+		_best.clear();
+
+		int cx = column(p.x), cy = row(p.y);
+		int maxRing = std::max(_nx, _ny);
+
+		for (int r = 0; r <= maxRing; r++)
+		{
+			// Nothing further out can beat the k-th candidate
+			if ((int)_best.size() == k && (r - 1) * _cell > _best.back().first) break;
+
+			for (int y = cy - r; y <= cy + r; y++)
+			{
+				if (y < 0 || y >= _ny) continue;
+				int step = (y == cy - r || y == cy + r) ? 1 : 2 * r;
+				for (int x = cx - r; x <= cx + r; x += std::max(step, 1))
+				{
+					if (x < 0 || x >= _nx) continue;
+					const std::vector<uint32_t> &c = _cells[(std::size_t)y * _nx + x];
+					for (auto i = begin(c); i != end(c); i++)
+						offer(*i, EuclideanMST<T>::length(p, points[*i]), k);
+				}
+			}
+		}
+
+		for (auto b = begin(_best); b != end(_best); b++) out.push_back(b->second);
+	}
+
+private:
+	int column(double x) const { return std::min(std::max((int)((x - _minX) / _cell), 0), _nx - 1); }
+	int row(double y) const { return std::min(std::max((int)((y - _minY) / _cell), 0), _ny - 1); }
+	std::size_t cellOf(const VertexType &p) const { return (std::size_t)row(p.y) * _nx + column(p.x); }
+
+	void offer(uint32_t id, double d, int k)
+	{
+		if ((int)_best.size() == k && d >= _best.back().first) return;
+		auto at = std::upper_bound(begin(_best), end(_best), std::make_pair(d, id));
+		_best.insert(at, std::make_pair(d, id));
+		if ((int)_best.size() > k) _best.pop_back();
+	}
+
+	double _minX = 0, _minY = 0, _cell = 1;
+	int _nx = 1, _ny = 1;
+	std::vector<std::vector<uint32_t>> _cells;
+	std::vector<std::pair<double, uint32_t>> _best;
+};
+
+// Greedy incremental Steiner insertion. Starting from the MST of the
+// terminals, every candidate is connected to its nearest tree vertices; each
+// new edge that closes a cycle replaces the longest edge of that cycle.
+// The candidate stays only if the tree got shorter, otherwise the few
+// changes are rolled back. Steiner points left with degree <= 2 are removed
+// after every pass. O(passes * candidates * k * path) instead of 2^k MSTs.
+template <class T>
+class GreedySteiner
+{
+public:
+	using VertexType = Vector2<T>;
+
+	// Number of nearest tree vertices a candidate is connected to
+	void setNeighbours(int k) { _neighbours = std::max(k, 1); }
+	// Maximum number of passes over the candidates
+	void setPasses(int passes) { _passes = std::max(passes, 1); }
+	// solve() stops inserting at the deadline and returns the tree it has
+	void setDeadline(std::chrono::steady_clock::time_point deadline) { _deadline = deadline; }
+	bool timedOut() const { return _timedOut; }
+
+	float solve(const std::vector<VertexType> &terminals, const std::vector<VertexType> &candidates)
+	{
+		PROFILE_SCOPE("GreedySteiner::solve");
+
+		_points = terminals;
+		_terminals = terminals.size();
+		// The lists grow only and are emptied, never freed, between solves
+		if (_adjacency.size() < _points.size()) _adjacency.resize(_points.size());
+		for (std::size_t i = 0; i < _points.size(); i++) _adjacency[i].clear();
+		_source.assign(_points.size(), -1);
+		_alive.assign(_points.size(), 1);
+		_tree.clear();
+		_chosen.clear();
+		_timedOut = false;
+
+		_length = _mst.build(terminals);
+		const std::vector<IndexEdge> &tree = _mst.getTree();
+		for (auto e = begin(tree); e != end(tree); e++) link(e->a, e->b);
+
+		if (terminals.empty())
+		{
+			_points.clear();
+			return 0;
+		}
+
+		// Grid over everything that may ever be in the tree
+		double minX = terminals[0].x, minY = terminals[0].y, maxX = minX, maxY = minY;
+		for (int pass = 0; pass < 2; pass++)
+		{
+			const std::vector<VertexType> &set = pass == 0 ? terminals : candidates;
+			for (auto v = begin(set); v != end(set); v++)
+			{
+				minX = std::min(minX, (double)v->x); maxX = std::max(maxX, (double)v->x);
+				minY = std::min(minY, (double)v->y); maxY = std::max(maxY, (double)v->y);
+			}
+		}
+		_grid.reset(minX, minY, maxX, maxY, terminals.size() + candidates.size() / 4);
+		for (uint32_t i = 0; i < _terminals; i++) _grid.insert(i, _points[i]);
+
+		std::vector<char> &used = _used;
+		used.assign(candidates.size(), 0);
+		for (int pass = 0; pass < _passes; pass++)
+		{
+			bool improved = false;
+			for (std::size_t i = 0; i < candidates.size() && !_timedOut; i++)
+			{
+				if (i % 64 == 0 && std::chrono::steady_clock::now() > _deadline) _timedOut = true;
+				if (used[i] || _timedOut) continue;
+				if (tryInsert(candidates[i], (int)i))
+				{
+					used[i] = 1;
+					improved = true;
+				}
+			}
+
+			// Steiner points that ended up with degree <= 2 only lengthen the tree
+			removeUseless(used);
+
+			if (!improved || _timedOut) break;
+		}
+
+		compact();
+		return (float)_length;
+	}
+
+	// Terminals first, then the Steiner points kept in the tree
+	const std::vector<VertexType>& getPoints() const { return _points; }
+	const std::vector<IndexEdge>& getTree() const { return _tree; }
+	// Candidate index of every kept Steiner point, in getPoints() order
+	const std::vector<int>& getChosen() const { return _chosen; }
+
+private:
+	double length(uint32_t a, uint32_t b) const { return EuclideanMST<T>::length(_points[a], _points[b]); }
+
+	void link(uint32_t a, uint32_t b)
+	{
+		_adjacency[a].push_back(b);
+		_adjacency[b].push_back(a);
+	}
+
+	void unlink(uint32_t a, uint32_t b)
+	{
+		std::vector<uint32_t> &x = _adjacency[a], &y = _adjacency[b];
+		x.erase(std::find(begin(x), end(x), b));
+		y.erase(std::find(begin(y), end(y), a));
+	}
+
+	// Longest edge on the tree path between a and b. The search gives up
+	// (longest = -1) once it has visited searchLimit vertices, which keeps
+	// every update local; the edge is then simply not added.
+	IndexEdge longestOnPath(uint32_t a, uint32_t b, double &longest)
+	{
+		if (_stamp.size() < _points.size())
+		{
+			_stamp.resize(_points.size(), 0);
+			_from.resize(_points.size());
+		}
+		if (++_visit == 0)
+		{
+			std::fill(begin(_stamp), end(_stamp), 0);
+			_visit = 1;
+		}
+
+		_queue.clear();
+		_queue.push_back(a);
+		_stamp[a] = _visit;
+		for (std::size_t i = 0; i < _queue.size() && i < searchLimit && _stamp[b] != _visit; i++)
+		{
+			uint32_t u = _queue[i];
+			for (auto v = begin(_adjacency[u]); v != end(_adjacency[u]); v++)
+			{
+				if (_stamp[*v] == _visit) continue;
+				_stamp[*v] = _visit;
+				_from[*v] = u;
+				_queue.push_back(*v);
+			}
+		}
+
+		IndexEdge result(a, a);
+		longest = -1;
+		if (_stamp[b] != _visit) return result;
+
+		for (uint32_t v = b; v != a; v = _from[v])
+		{
+			double l = length(v, _from[v]);
+			if (l > longest) { longest = l; result = IndexEdge(_from[v], v); }
+		}
+		return result;
+	}
+
+	bool tryInsert(const VertexType &candidate, int source)
+	{
+		_grid.nearest(candidate, _neighbours, _points, _near);
+		if (_near.empty()) return false;
+
+		uint32_t id = (uint32_t)_points.size();
+		_points.push_back(candidate);
+		if (_adjacency.size() <= id) _adjacency.resize(id + 1);
+		_adjacency[id].clear();
+		_source.push_back(source);
+		_alive.push_back(1);
+
+		// Local update: every further edge to the candidate closes one cycle
+		_added.clear();
+		_removed.clear();
+		double delta = length(id, _near[0]);
+		link(id, _near[0]);
+		_added.push_back(IndexEdge(id, _near[0]));
+
+		for (std::size_t i = 1; i < _near.size(); i++)
+		{
+			double d = length(id, _near[i]), longest;
+			IndexEdge e = longestOnPath(_near[i], id, longest);
+			if (longest <= d) continue;
+
+			unlink(e.a, e.b);
+			_removed.push_back(e);
+			link(id, _near[i]);
+			_added.push_back(IndexEdge(id, _near[i]));
+			delta += d - longest;
+		}
+
+		if (delta < -1e-9 * (1 + _length) && _adjacency[id].size() >= 3)
+		{
+			_length += delta;
+			_grid.insert(id, candidate);
+			return true;
+		}
+
+		// Roll back
+		for (auto e = _added.rbegin(); e != _added.rend(); e++) unlink(e->a, e->b);
+		for (auto e = _removed.rbegin(); e != _removed.rend(); e++) link(e->a, e->b);
+		_points.pop_back();
+		_source.pop_back();
+		_alive.pop_back();
+		return false;
+	}
+
+	void removeUseless(std::vector<char> &used)
+	{
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+			for (uint32_t s = (uint32_t)_terminals; s < _points.size(); s++)
+			{
+				if (!_alive[s] || _adjacency[s].size() > 2) continue;
+
+				std::vector<uint32_t> &n = _star;
+				n = _adjacency[s];
+				for (auto v = begin(n); v != end(n); v++)
+				{
+					_length -= length(s, *v);
+					unlink(s, *v);
+				}
+				if (n.size() == 2)
+				{
+					_length += length(n[0], n[1]);
+					link(n[0], n[1]);
+				}
+
+				_alive[s] = 0;
+				_grid.remove(s, _points[s]);
+				used[_source[s]] = 0;
+				changed = true;
+			}
+		}
+	}
+
+	// Drop removed Steiner points and build the edge list
+	void compact()
+	{
+		std::vector<uint32_t> &index = _index;
+		index.resize(_points.size());
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < _points.size(); i++)
+		{
+			index[i] = (uint32_t)count;
+			if (!_alive[i]) continue;
+			if (i >= _terminals) _chosen.push_back(_source[i]);
+			_points[count++] = _points[i];
+		}
+
+		for (uint32_t a = 0; a < index.size(); a++)
+			for (auto b = begin(_adjacency[a]); b != end(_adjacency[a]); b++)
+				if (a < *b) _tree.push_back(IndexEdge(index[a], index[*b]));
+
+		_points.resize(count);
+	}
+
+	static const std::size_t searchLimit = 1024;
+
+	int _neighbours = 6;
+	int _passes = 3;
+	std::chrono::steady_clock::time_point _deadline = std::chrono::steady_clock::time_point::max();
+	bool _timedOut = false;
+
+	std::vector<VertexType> _points;
+	std::size_t _terminals = 0;
+	std::vector<std::vector<uint32_t>> _adjacency;
+	std::vector<int> _source;
+	std::vector<char> _alive;
+	std::vector<IndexEdge> _tree;
+	std::vector<int> _chosen;
+	double _length = 0;
+
+	EuclideanMST<T> _mst;
+	PointGrid<T> _grid;
+	std::vector<uint32_t> _near;
+	std::vector<IndexEdge> _added, _removed;
+	std::vector<uint32_t> _star, _index;
+	std::vector<char> _used;
+
+	std::vector<uint32_t> _stamp, _from, _queue;
+	uint32_t _visit = 0;
+};
+
+#endif
@@ -0,0 +1,214 @@
+#ifndef H_LOADER
+#define H_LOADER
+
+#include "vector2.h"
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <charconv>
+#include <omp.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Read-only memory map of a whole file
+class MappedFile
+{
+public:
+	MappedFile(const char *path) : _data(nullptr), _size(0)
+	{
+#ifdef _WIN32
+		_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (_file == INVALID_HANDLE_VALUE) throw "Cant open file / Wrong way";
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(_file, &size);
+		_size = (std::size_t)size.QuadPart;
+		_mapping = NULL;
+		if (_size == 0) return;
+
+		_mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (_mapping) _data = (const char*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		_file = open(path, O_RDONLY);
+		if (_file < 0) throw "Cant open file / Wrong way";
+
+		struct stat st;
+		fstat(_file, &st);
+		_size = (std::size_t)st.st_size;
+		if (_size == 0) return;
+
+		void *data = mmap(NULL, _size, PROT_READ, MAP_PRIVATE, _file, 0);
+		if (data != MAP_FAILED)
+		{
+			_data = (const char*)data;
+			madvise(data, _size, MADV_SEQUENTIAL);
+		}
+#endif
+		if (!_data)
+		{
+			close();
+			throw "Cant map file";
+		}
+	}
+
+	~MappedFile() { close(); }
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+
+	const char* data() const { return _data; }
+	std::size_t size() const { return _size; }
+
+private:
+	void close()
+	{
+#ifdef _WIN32
+		if (_data) UnmapViewOfFile(_data);
+		if (_mapping) CloseHandle(_mapping);
+		if (_file != INVALID_HANDLE_VALUE) CloseHandle(_file);
+		_mapping = NULL;
+		_file = INVALID_HANDLE_VALUE;
+#else
+		if (_data) munmap((void*)_data, _size);
+		if (_file >= 0) ::close(_file);
+		_file = -1;
+#endif
+		_data = nullptr;
+	}
+
+#ifdef _WIN32
+	HANDLE _file;
+	HANDLE _mapping;
+#else
+	int _file;
+#endif
+	const char *_data;
+	std::size_t _size;
+};
+
+// One coordinate. Integer types read integers exactly (no round trip
+// through double, which would lose int64 digits); a value written as a
+// decimal is rounded, and out of range when the type cannot hold it.
+template <class T>
+std::from_chars_result parseCoordinate(const char *first, const char *last, T &value)
+{
+	if constexpr (std::is_integral<T>::value)
+	{
+		std::from_chars_result r = std::from_chars(first, last, value);
+		if (r.ec != std::errc() || r.ptr == last || (*r.ptr != '.' && *r.ptr != 'e' && *r.ptr != 'E')) return r;
+	}
+
+	double d;
+	std::from_chars_result r = std::from_chars(first, last, d);
+	if (r.ec == std::errc())
+	{
+		if (fitsCoordinate<T>(d)) value = toCoordinate<T>(d);
+		else r.ec = std::errc::result_out_of_range;
+	}
+	return r;
+}
+
+// Parses "x y" lines of [first, last) into points. Blank lines are skipped,
+// coordinates may be integer or floating-point. Returns the number of lines
+// read, or sets error to the (1-based, local) number of the first bad line.
+template <class T>
+std::size_t parsePoints(const char *first, const char *last, std::vector<Vector2<T>> &points, std::size_t &error)
+{
+	std::size_t line = 0;
+	error = 0;
+
+	while (first < last)
+	{
+		line++;
+
+		const char *end = first;
+		while (end < last && *end != '\n') end++;
+
+		T c[2];
+		int count = 0;
+		const char *p = first;
+		for (;;)
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',')) p++;
+			if (p == end) break;
+			if (*p == '+') p++;
+
+			if (count == 2) { error = line; return line; }
+
+			std::from_chars_result r = parseCoordinate(p, end, c[count]);
+			if (r.ec != std::errc() || (r.ptr < end && *r.ptr != ' ' && *r.ptr != '\t' && *r.ptr != '\r' && *r.ptr != ','))
+			{
+				error = line;
+				return line;
+			}
+			count++;
+			p = r.ptr;
+		}
+
+		if (count == 2) points.push_back(Vector2<T>(c[0], c[1]));
+		else if (count != 0) { error = line; return line; }
+
+		first = end + 1;
+	}
+
+	return line;
+}
+
+// Loads a point file in a single pass over a memory map. Large files are
+// parsed in parallel chunks split at line boundaries.
+template <class T>
+std::vector<Vector2<T>> loadPoints(const char *path)
+{
+	MappedFile file(path);
+	const char *data = file.data();
+	const std::size_t size = file.size();
+
+	// Chunks of at least 1 MB, each one starting right after a newline
+	const std::size_t minChunk = 1 << 20;
+	int chunks = (int)std::min<std::size_t>(omp_get_max_threads(), size / minChunk + 1);
+
+	std::vector<std::size_t> bounds(chunks + 1, size);
+	bounds[0] = 0;
+	for (int i = 1; i < chunks; i++)
+	{
+		std::size_t b = std::max(bounds[i - 1], size / chunks * i);
+		while (b < size && data[b - 1] != '\n') b++;
+		bounds[i] = b;
+	}
+
+	std::vector<std::vector<Vector2<T>>> parts(chunks);
+	std::vector<std::size_t> lines(chunks), errors(chunks);
+
+	#pragma omp parallel for schedule(static, 1) if (chunks > 1)
+	for (int i = 0; i < chunks; i++)
+	{
+		parts[i].reserve((bounds[i + 1] - bounds[i]) / 8);
+		lines[i] = parsePoints(data + bounds[i], data + bounds[i + 1], parts[i], errors[i]);
+	}
+
+	std::size_t total = 0, offset = 0;
+	for (int i = 0; i < chunks; i++)
+	{
+		if (errors[i])
+			throw std::runtime_error(std::string(path) + ": malformed point at line " + std::to_string(offset + errors[i]));
+		offset += lines[i];
+		total += parts[i].size();
+	}
+
+	std::vector<Vector2<T>> points;
+	points.reserve(total);
+	for (int i = 0; i < chunks; i++)
+		points.insert(end(points), begin(parts[i]), end(parts[i]));
+
+	return points;
+}
+
+#endif
@@ -1,60 +1,184 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <fstream>
 #include <vector>
 #include <math.h>
 #include <iterator>
 #include <omp.h>
 #include <chrono>
+#include <stdexcept>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
 //-----------
 #include "vector2.h"
 #include "triangle.h"
+#include "mesh.h"
 #include "delaunay.h"
+#include "delaunaydc.h"
 #include "steiner.h"
 #include "prim.h"
+#include "anytime.h"
+#include "tiled.h"
+#include "solution.h"
+#include "profile.h"
 
 using namespace std::chrono;
 
-int main()
+// Peak resident memory of the process in MB, -1 where unknown
+static double peakMemory()
+{
+#ifdef _WIN32
+	return -1;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+	return usage.ru_maxrss / 1024.0;	// Kilobytes on Linux
+#endif
+}
+
+// main [points] [--quiet] [--output <file>] [--binary] [--budget <ms>] [--tiled]
+//   --quiet   don't write the tree, only the summary and the times
+//   --output  write the tree to a file instead of stdout
+//   --binary  binary solution file (SolutionHeader), needs --output
+//   --budget  solve with AnytimeSteiner, best tree found in <ms>
+//   --tiled   solve with TiledSteiner, no triangulation of the whole set
+int main(int argc, char **argv)
 {
 	char path[255] = "files/good.dat";
-	
-	// Divide our graph into triangles (Delaunay triangulation) -(1)-
-	
-	auto start = high_resolution_clock::now(); // Time count start
+	const char *output = nullptr;
+	bool quiet = false, tiled = false;
+	long budget = -1;
+	OutputFormat format = OutputFormat::Text;
 
-	Delaunay<float> triangulation;
-	std::vector<Triangle<float>> triangles = triangulation.Load(path);
-	
-	auto stop = high_resolution_clock::now(); // Time count stop
-	auto duration1 = duration_cast<milliseconds>(stop - start); // Time count
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "--quiet") || !strcmp(argv[i], "-q")) quiet = true;
+		else if (!strcmp(argv[i], "--binary")) format = OutputFormat::Binary;
+		else if (!strcmp(argv[i], "--tiled")) tiled = true;
+		else if (!strcmp(argv[i], "--output") && i + 1 < argc) output = argv[++i];
+		else if (!strcmp(argv[i], "--budget") && i + 1 < argc) budget = atol(argv[++i]);
+		else snprintf(path, sizeof(path), "%s", argv[i]);
+	}
 
-	// Create additional vertices -------------------------------(2)-
-	
-	start = high_resolution_clock::now(); 
+	if (format == OutputFormat::Binary && !output)
+	{
+		printf("--binary needs --output <file>\n");
+		return 1;
+	}
+
+	if (budget == 0 || budget < -1)
+	{
+		printf("--budget needs a time in milliseconds\n");
+		return 1;
+	}
+
+	if (tiled && budget > 0)
+	{
+		printf("--tiled and --budget do not go together\n");
+		return 1;
+	}
 	
-	Steiner<float> steiner;
-	std::vector<Vector2<float>> steinerpoints = steiner.additionalVertices(triangles);
+	try
+	{
+		// Divide our graph into triangles (Delaunay triangulation) -(1)-
 
-	stop = high_resolution_clock::now(); 
-	auto duration2 = duration_cast<milliseconds>(stop - start); 
+		auto start = high_resolution_clock::now(); // Time count start
 
-	// Find shortest path ---------------------------------------(3)-
+		DelaunayDC<float> triangulation; // Parallel divide-and-conquer, Delaunay<float> is the incremental one
+		const Mesh<float> *mesh = nullptr;
+		std::vector<Vector2<float>> terminals;
 
-	start = high_resolution_clock::now(); 
+		// The tiled solver triangulates tile by tile, only the points are loaded
+		if (!tiled) mesh = &triangulation.Load(path);
+		else if (isPointSetFile(path))
+		{
+			PointSetView<float> view(path);
+			terminals.assign(view.begin(), view.end());
+		}
+		else terminals = loadPoints<float>(path);
 
-	std::vector<Vector2<float>> points = triangulation.getVertices();
-	Prim<float> prim;
-	
-	float result = prim.shortestPath(points, steinerpoints); // Provides final solution
+		auto stop = high_resolution_clock::now(); // Time count stop
+		auto duration1 = duration_cast<milliseconds>(stop - start); // Time count
+
+		// Create additional vertices -------------------------------(2)-
+
+		start = high_resolution_clock::now(); 
+
+		// The anytime solver finds its own candidates, against the clock
+		Steiner<float> steiner;
+		std::vector<Vector2<float>> steinerpoints;
+		if (budget < 0 && !tiled) steinerpoints = steiner.additionalVertices(*mesh);
+
+		stop = high_resolution_clock::now(); 
+		auto duration2 = duration_cast<milliseconds>(stop - start); 
+
+		// Find shortest path ---------------------------------------(3)-
+
+		start = high_resolution_clock::now(); 
+
+		Prim<float> prim;
+		AnytimeSteiner<float> anytime;
+		TiledSteiner<float> tiles;
+		SteinerSolution<float> timed;
+		const SteinerSolution<float> *solution = &prim.getSolution();
+		float result;
+
+		if (tiled)
+		{
+			solution = &tiles.solve(terminals);
+			result = solution->length;
+		}
+		else if (budget < 0) result = prim.shortestPath(*mesh, steinerpoints); // Provides final solution
+		else
+		{
+			timed = anytime.solve(mesh->vertices, milliseconds(budget));
+			solution = &timed;
+			result = timed.length;
+		}
+
+		stop = high_resolution_clock::now(); 
+		auto duration3 = duration_cast<milliseconds>(stop - start); 
+
+		// Write the tree, a stage of its own -----------------------(4)-
+
+		start = high_resolution_clock::now(); 
+
+		if (output) writeSolution(output, *solution, format);
+		else if (!quiet)
+		{
+			SolutionWriter<float> writer(stdout);
+			writer.writeText(*solution);
+		}
+
+		if (output || quiet) printf("Summary: %.2lf \n", result);
+		if (budget > 0) printf("%s within %ld ms\n", solution->optimal ? "Optimal" : "Not proven optimal", budget);
+
+		stop = high_resolution_clock::now(); 
+		auto duration4 = duration_cast<milliseconds>(stop - start); 
 
-	stop = high_resolution_clock::now(); 
-	auto duration3 = duration_cast<milliseconds>(stop - start); 
+		// Show execution time for every part -----------------------(5)-
 
-	// Show execution time for every part -----------------------(4)-
+		std::cout << std::endl << "Time: " << std::endl << "Delaunay: " << duration1.count() << std::endl;
+		std::cout << "Steiner:  " << duration2.count() << std::endl;
+		std::cout << "Prim:     " << duration3.count() << std::endl;
+		std::cout << "Output:   " << duration4.count() << std::endl;
+		if (peakMemory() >= 0) printf("Peak memory: %.0f MB\n", peakMemory());
 
-	std::cout << std::endl << "Time: " << std::endl << "Delaunay: " << duration1.count() << std::endl;
-	std::cout << "Steiner:  " << duration2.count() << std::endl;
-	std::cout << "Prim:     " << duration3.count() << std::endl;
+		// Only with -DSMT_PROFILE
+		PROFILE_WRITE("profile.json", "trace.json");
+	}
+	catch (const char *error)
+	{
+		printf("%s\n", error);
+		return 1;
+	}
+	catch (const std::exception &error)
+	{
+		printf("%s\n", error.what());
+		return 1;
+	}
 
 	return 0;
 }
@@ -0,0 +1,55 @@
+#ifndef H_MESH
+#define H_MESH
+
+#include "vector2.h"
+
+#include <vector>
+#include <stdint.h>
+
+// Triangle as three 32-bit vertex indices, counter-clockwise
+struct IndexTriangle
+{
+	IndexTriangle() {}
+	IndexTriangle(uint32_t a, uint32_t b, uint32_t c) { v[0] = a; v[1] = b; v[2] = c; }
+
+	uint32_t v[3];
+};
+
+// Undirected edge as two 32-bit vertex indices
+struct IndexEdge
+{
+	IndexEdge() {}
+	IndexEdge(uint32_t a, uint32_t b) : a(a), b(b) {}
+
+	uint32_t a;
+	uint32_t b;
+};
+
+inline bool operator == (const IndexEdge &e1, const IndexEdge &e2)
+{
+	return (e1.a == e2.a && e1.b == e2.b) || (e1.a == e2.b && e1.b == e2.a);
+}
+
+// Compact triangulation: the vertices are stored once and triangles and
+// edges refer to them by index. Every edge is listed exactly once.
+template <class T>
+class Mesh
+{
+public:
+	using VertexType = Vector2<T>;
+
+	void clear()
+	{
+		vertices.clear();
+		triangles.clear();
+		edges.clear();
+	}
+
+	const VertexType& vertex(const IndexTriangle &t, int i) const { return vertices[t.v[i]]; }
+
+	std::vector<VertexType> vertices;
+	std::vector<IndexTriangle> triangles;
+	std::vector<IndexEdge> edges;
+};
+
+#endif
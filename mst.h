@@ -0,0 +1,163 @@
+#ifndef H_MST
+#define H_MST
+
+#include "vector2.h"
+#include "mesh.h"
+#include "delaunaydc.h"
+#include "profile.h"
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+
+// Disjoint-set forest with union by size and path halving
+class DisjointSet
+{
+public:
+	void reset(std::size_t n)
+	{
+		_parent.resize(n);
+		_size.assign(n, 1);
+		for (std::size_t i = 0; i < n; i++) _parent[i] = (uint32_t)i;
+	}
+
+	uint32_t find(uint32_t v)
+	{
+		while (_parent[v] != v)
+		{
+			_parent[v] = _parent[_parent[v]];
+			v = _parent[v];
+		}
+		return v;
+	}
+
+	// Returns false when a and b were already in the same set
+	bool unite(uint32_t a, uint32_t b)
+	{
+		a = find(a); b = find(b);
+		if (a == b) return false;
+		if (_size[a] < _size[b]) std::swap(a, b);
+		_parent[b] = a;
+		_size[a] += _size[b];
+		return true;
+	}
+
+private:
+	std::vector<uint32_t> _parent;
+	std::vector<uint32_t> _size;
+};
+
+// Euclidean minimum spanning tree. The EMST is a subgraph of the Delaunay
+// triangulation, so Kruskal only has to look at its O(n) edges:
+// O(n log n) time and O(n) memory instead of a dense n x n matrix.
+template <class T>
+class EuclideanMST
+{
+public:
+	using VertexType = Vector2<T>;
+
+	// Returns the tree length, the edges are available from getTree()
+	float build(const std::vector<VertexType> &vertices)
+	{
+		PROFILE_SCOPE("EuclideanMST::build");
+
+		_tree.clear();
+		_candidates.clear();
+		if (vertices.size() < 2) return 0;
+
+		// Below a few dozen points the triangulation costs more than it saves
+		if (vertices.size() <= denseLimit) return dense(vertices);
+
+		_set.reset(vertices.size());
+
+		// Duplicate points are not part of the triangulation, tie them to their twin
+		_order.resize(vertices.size());
+		for (std::size_t i = 0; i < _order.size(); i++) _order[i] = (uint32_t)i;
+		std::sort(begin(_order), end(_order), [&](uint32_t a, uint32_t b) {
+			return vertices[a].x < vertices[b].x || (vertices[a].x == vertices[b].x && vertices[a].y < vertices[b].y);
+		});
+		for (std::size_t i = 1; i < _order.size(); i++)
+		{
+			if (vertices[_order[i]] == vertices[_order[i - 1]])
+			{
+				_set.unite(_order[i - 1], _order[i]);
+				_tree.push_back(IndexEdge(_order[i - 1], _order[i]));
+			}
+		}
+
+		const Mesh<T> &mesh = _delaunay.triangulate(vertices.data(), vertices.size());
+
+		for (auto e = begin(mesh.edges); e != end(mesh.edges); e++)
+			_candidates.push_back(Candidate(length(vertices[e->a], vertices[e->b]), *e));
+
+		std::sort(begin(_candidates), end(_candidates), [](const Candidate &a, const Candidate &b) {
+			return a.first < b.first;
+		});
+
+		double summary = 0;
+		for (auto c = begin(_candidates); c != end(_candidates) && _tree.size() + 1 < vertices.size(); c++)
+		{
+			if (_set.unite(c->second.a, c->second.b))
+			{
+				_tree.push_back(c->second);
+				summary += c->first;
+			}
+		}
+
+		return (float)summary;
+	}
+
+	const std::vector<IndexEdge>& getTree() const { return _tree; }
+
+	static double length(const VertexType &v1, const VertexType &v2)
+	{
+		double dx = (double)v2.x - v1.x, dy = (double)v2.y - v1.y;
+		return sqrt(dx * dx + dy * dy);
+	}
+
+private:
+	using Candidate = std::pair<double, IndexEdge>;
+
+	static const std::size_t denseLimit = 32;
+
+	// O(n^2) Prim straight on the points
+	float dense(const std::vector<VertexType> &vertices)
+	{
+		const std::size_t n = vertices.size();
+		_key.assign(n, DBL_MAX);
+		_from.assign(n, 0);
+		_inTree.assign(n, 0);
+
+		double summary = 0;
+		uint32_t u = 0;
+		for (std::size_t count = 1; count < n; count++)
+		{
+			_inTree[u] = 1;
+			uint32_t next = 0;
+			double min = DBL_MAX;
+			for (uint32_t v = 0; v < n; v++)
+			{
+				if (_inTree[v]) continue;
+				double d = length(vertices[u], vertices[v]);
+				if (d < _key[v]) { _key[v] = d; _from[v] = u; }
+				if (_key[v] < min) { min = _key[v]; next = v; }
+			}
+			_tree.push_back(IndexEdge(_from[next], next));
+			summary += min;
+			u = next;
+		}
+		return (float)summary;
+	}
+
+	DelaunayDC<T> _delaunay;
+	DisjointSet _set;
+	std::vector<uint32_t> _order;
+	std::vector<Candidate> _candidates;
+	std::vector<IndexEdge> _tree;
+	std::vector<double> _key;
+	std::vector<uint32_t> _from;
+	std::vector<char> _inTree;
+};
+
+#endif
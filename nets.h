@@ -0,0 +1,221 @@
+#ifndef H_NETS
+#define H_NETS
+
+#include "vector2.h"
+#include "mesh.h"
+#include "loader.h"
+#include "delaunaydc.h"
+#include "steiner.h"
+#include "mst.h"
+#include "greedy.h"
+#include "dynamicmst.h"
+#include "topology.h"
+#include "solution.h"
+#include "profile.h"
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <stdexcept>
+#include <omp.h>
+
+// Many small point sets (nets) stored back to back
+template <class T>
+struct NetList
+{
+	using VertexType = Vector2<T>;
+
+	void clear()
+	{
+		points.clear();
+		names.clear();
+		offsets.assign(1, 0);
+	}
+
+	void add(const std::string &name, const VertexType *first, std::size_t count)
+	{
+		if (offsets.empty()) offsets.push_back(0);
+		points.insert(end(points), first, first + count);
+		names.push_back(name);
+		offsets.push_back(points.size());
+	}
+
+	std::size_t size() const { return names.size(); }
+	const VertexType* net(std::size_t i) const { return points.data() + offsets[i]; }
+	std::size_t count(std::size_t i) const { return offsets[i + 1] - offsets[i]; }
+
+	std::vector<VertexType> points;
+	std::vector<std::string> names;
+	std::vector<std::size_t> offsets = std::vector<std::size_t>(1, 0);
+};
+
+// Reads a file of nets: a line "net [name]" starts a net, the point lines
+// after it are as in files/good.dat. Points before the first "net" line form
+// an unnamed net.
+template <class T>
+NetList<T> loadNets(const char *path)
+{
+	MappedFile file(path);
+	const char *data = file.data(), *last = data + file.size();
+
+	NetList<T> nets;
+	std::string name;
+	bool open = false;
+	std::size_t line = 0, start = 0;
+	const char *first = data, *body = data;
+
+	// Parses the points of the current net, from body up to p
+	auto close = [&](const char *p) {
+		std::size_t error;
+		parsePoints(body, p, nets.points, error);
+		if (error) throw std::runtime_error(std::string(path) + ": malformed point at line " + std::to_string(start + error));
+		if (open || nets.points.size() > nets.offsets.back())
+		{
+			nets.names.push_back(name);
+			nets.offsets.push_back(nets.points.size());
+		}
+	};
+
+	while (first < last)
+	{
+		line++;
+		const char *end = first;
+		while (end < last && *end != '\n') end++;
+
+		const char *p = first;
+		while (p < end && (*p == ' ' || *p == '\t')) p++;
+		// "net" alone or followed by whitespace; "network 1 2" is no header
+		if (end - p >= 3 && p[0] == 'n' && p[1] == 'e' && p[2] == 't'
+			&& (end - p == 3 || p[3] == ' ' || p[3] == '\t' || p[3] == '\r'))
+		{
+			close(first);
+
+			p += 3;
+			while (p < end && (*p == ' ' || *p == '\t')) p++;
+			const char *q = end;
+			while (q > p && (q[-1] == '\r' || q[-1] == ' ' || q[-1] == '\t')) q--;
+			name.assign(p, q);
+			open = true;
+			start = line;
+			body = end < last ? end + 1 : last;
+		}
+
+		first = end + 1;
+	}
+	close(last);
+
+	return nets;
+}
+
+// Solves every net of a NetList, nets spread over the OpenMP threads. Each
+// thread keeps one workspace (triangulation, candidates, MST, searches) for
+// the life of the solver: its buffers are cleared between nets, not freed,
+// so after the first few nets nothing is allocated any more.
+template <class T>
+class BatchSolver
+{
+public:
+	using VertexType = Vector2<T>;
+	using Clock = std::chrono::steady_clock;
+
+	// Nets with at most this many candidates are solved exactly (Gray code)
+	void setExactLimit(std::size_t limit) { _exactLimit = std::min(limit, GrayCodeSteiner<T>::maxCandidates); }
+
+	// Nets of up to maxTerminals are solved from the topology table instead
+	// of the triangulation (nullptr turns it off); past 4 it is not faster
+	void setTopologyTable(const TopologyTable *table, std::size_t maxTerminals = 4)
+	{
+		_table = table;
+		_tableMaxTerminals = maxTerminals;
+	}
+
+	const std::vector<SteinerSolution<T>>& solve(const NetList<T> &nets)
+	{
+		PROFILE_SCOPE("BatchSolver::solve");
+		const Clock::time_point start = Clock::now();
+
+		while (_workspaces.size() < (std::size_t)omp_get_max_threads())
+			_workspaces.push_back(std::unique_ptr<Workspace>(new Workspace()));
+		for (auto w = begin(_workspaces); w != end(_workspaces); w++)
+			(*w)->small.setTable(_table, _tableMaxTerminals);
+		_results.resize(nets.size());
+
+		#pragma omp parallel for schedule(dynamic, 16)
+		for (int64_t i = 0; i < (int64_t)nets.size(); i++)
+			solveNet(*_workspaces[omp_get_thread_num()], nets.net(i), nets.count(i), _results[i]);
+
+		_elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		return _results;
+	}
+
+	const std::vector<SteinerSolution<T>>& getResults() const { return _results; }
+	// Seconds spent in the last solve()
+	double getElapsed() const { return _elapsed; }
+
+private:
+	struct Workspace
+	{
+		DelaunayDC<T> delaunay;
+		Steiner<T> steiner;
+		EuclideanMST<T> mst;
+		GreedySteiner<T> greedy;
+		GrayCodeSteiner<T> grayCode;
+		SmallNetSteiner<T> small;
+		std::vector<VertexType> terminals, candidates;
+	};
+
+	void solveNet(Workspace &w, const VertexType *points, std::size_t count, SteinerSolution<T> &result)
+	{
+		const Clock::time_point start = Clock::now();
+
+		if (w.small.solve(points, count, result))
+		{
+			result.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+			return;
+		}
+
+		w.terminals.assign(points, points + count);
+		result.points.assign(points, points + count);
+		result.tree.clear();
+		result.length = 0;
+		result.optimal = true;
+
+		if (count > 2)
+		{
+			const Mesh<T> &mesh = w.delaunay.triangulate(points, count);
+			w.candidates.resize(mesh.triangles.size());
+			w.candidates.resize(w.steiner.additionalVertices(mesh, w.candidates.data(), w.candidates.size()));
+		}
+		else
+			w.candidates.clear();
+
+		if (w.candidates.size() <= _exactLimit)
+		{
+			uint64_t best = w.candidates.empty() ? 0 : w.grayCode.solve(w.terminals, w.candidates);
+			for (std::size_t j = 0; j < w.candidates.size(); j++)
+				if (best >> j & 1) result.points.push_back(w.candidates[j]);
+
+			result.length = w.mst.build(result.points);
+			result.tree.assign(begin(w.mst.getTree()), end(w.mst.getTree()));
+		}
+		else
+		{
+			result.length = w.greedy.solve(w.terminals, w.candidates);
+			result.points.assign(begin(w.greedy.getPoints()), end(w.greedy.getPoints()));
+			result.tree.assign(begin(w.greedy.getTree()), end(w.greedy.getTree()));
+			result.optimal = false;
+		}
+
+		result.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	std::vector<std::unique_ptr<Workspace>> _workspaces;
+	std::vector<SteinerSolution<T>> _results;
+	const TopologyTable *_table = nullptr;
+	std::size_t _tableMaxTerminals = 4;
+	std::size_t _exactLimit = 12;
+	double _elapsed = 0;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef H_ORDERING
+#define H_ORDERING
+
+#include "vector2.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+// Order in which Delaunay::triangulate inserts the points
+enum class InsertionOrder
+{
+	Input,		// As given
+	Hilbert,	// Along a Hilbert curve
+	BRIO		// Biased randomized rounds, each one sorted along a Hilbert curve
+};
+
+// Position of cell (x, y) along the Hilbert curve filling a 2^16 x 2^16 grid
+inline uint64_t hilbertIndex(uint32_t x, uint32_t y)
+{
+	uint64_t d = 0;
+	for (uint32_t s = 1u << 15; s > 0; s >>= 1)
+	{
+		uint32_t rx = (x & s) > 0;
+		uint32_t ry = (y & s) > 0;
+		d += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+		// Rotate the quadrant
+		if (ry == 0)
+		{
+			if (rx == 1)
+			{
+				x = s - 1 - x;
+				y = s - 1 - y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+// Sorts indices [first, last) by the Hilbert index of their points
+template <class T>
+void hilbertSort(const Vector2<T> *vertices, std::vector<int>::iterator first, std::vector<int>::iterator last)
+{
+	if (first == last) return;
+
+	double minX = vertices[*first].x, minY = vertices[*first].y;
+	double maxX = minX, maxY = minY;
+	for (auto i = first; i != last; i++)
+	{
+		minX = std::min(minX, (double)vertices[*i].x); maxX = std::max(maxX, (double)vertices[*i].x);
+		minY = std::min(minY, (double)vertices[*i].y); maxY = std::max(maxY, (double)vertices[*i].y);
+	}
+
+	double scale = 65535.0 / std::max(std::max(maxX - minX, maxY - minY), 1e-30);
+
+	std::vector<std::pair<uint64_t, int>> keys;
+	keys.reserve(last - first);
+	for (auto i = first; i != last; i++)
+	{
+		uint32_t x = (uint32_t)((vertices[*i].x - minX) * scale);
+		uint32_t y = (uint32_t)((vertices[*i].y - minY) * scale);
+		keys.push_back(std::make_pair(hilbertIndex(x, y), *i));
+	}
+
+	std::sort(begin(keys), end(keys));
+	for (auto k = begin(keys); k != end(keys); k++, first++)
+		*first = k->second;
+}
+
+// Permutation of the vertex indices in the requested insertion order
+template <class T>
+std::vector<int> insertionOrder(const Vector2<T> *vertices, std::size_t count, InsertionOrder order)
+{
+	std::vector<int> result(count);
+	for (std::size_t i = 0; i < result.size(); i++) result[i] = (int)i;
+
+	if (order == InsertionOrder::Hilbert)
+		hilbertSort(vertices, begin(result), end(result));
+
+	if (order == InsertionOrder::BRIO)
+	{
+		// Every point survives into the next round with probability 1/2, so the
+		// last round holds about half of them. Rounds are inserted first to last.
+		const int maxRounds = 32;
+		std::vector<int> round(count);
+		uint32_t seed = 0x9e3779b9u;
+
+		for (std::size_t i = 0; i < round.size(); i++)
+		{
+			int r = 0;
+			while (r < maxRounds - 1)
+			{
+				seed ^= seed << 13; seed ^= seed >> 17; seed ^= seed << 5; // xorshift32
+				if (seed & 1) break;
+				r++;
+			}
+			round[i] = maxRounds - 1 - r;
+		}
+
+		std::stable_sort(begin(result), end(result), [&](int a, int b) { return round[a] < round[b]; });
+
+		auto first = begin(result);
+		while (first != end(result))
+		{
+			auto last = first;
+			while (last != end(result) && round[*last] == round[*first]) last++;
+			hilbertSort(vertices, first, last);
+			first = last;
+		}
+	}
+
+	return result;
+}
+
+template <class T>
+std::vector<int> insertionOrder(const std::vector<Vector2<T>> &vertices, InsertionOrder order)
+{
+	return insertionOrder(vertices.data(), vertices.size(), order);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef H_POINTSET
+#define H_POINTSET
+
+#include "vector2.h"
+#include "loader.h"
+
+#include <vector>
+#include <memory>
+#include <string.h>
+#include <stdio.h>
+#include <stdint.h>
+
+// Binary point set: a 32-byte header followed by count packed (x, y) pairs of
+// the stored coordinate type, laid out exactly like Vector2<T>. All values
+// are little-endian, the only byte order we run on.
+struct PointSetHeader
+{
+	char magic[4];			// "SMTP"
+	uint32_t version;		// Format version, currently 1
+	uint32_t type;			// Coordinate type, see coordinateType<T>()
+	uint32_t headerSize;	// Offset of the first point
+	uint64_t count;			// Number of points
+	uint64_t reserved;
+};
+
+static const uint32_t pointSetVersion = 1;
+
+template <class T> uint32_t coordinateType();
+template <> inline uint32_t coordinateType<int32_t>() { return 1; }
+template <> inline uint32_t coordinateType<int64_t>() { return 2; }
+template <> inline uint32_t coordinateType<float>() { return 3; }
+template <> inline uint32_t coordinateType<double>() { return 4; }
+
+// True when the file starts with the binary point set magic
+inline bool isPointSetFile(const char *path)
+{
+	char magic[4] = { 0 };
+	FILE *file = fopen(path, "rb");
+	if (!file) return false;
+	std::size_t read = fread(magic, 1, 4, file);
+	fclose(file);
+	return read == 4 && memcmp(magic, "SMTP", 4) == 0;
+}
+
+template <class T>
+void writePointSet(const char *path, const Vector2<T> *points, std::size_t count)
+{
+	PointSetHeader header;
+	memcpy(header.magic, "SMTP", 4);
+	header.version = pointSetVersion;
+	header.type = coordinateType<T>();
+	header.headerSize = sizeof(PointSetHeader);
+	header.count = count;
+	header.reserved = 0;
+
+	FILE *file = fopen(path, "wb");
+	if (!file) throw "Cant open file / Wrong way";
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (std::size_t i = 0; ok && i < count; i++)
+	{
+		T xy[2] = { points[i].x, points[i].y };
+		ok = fwrite(xy, sizeof(xy), 1, file) == 1;
+	}
+
+	if (fclose(file) != 0 || !ok) throw "Cant write file";
+}
+
+// Converts a text point file into the binary format
+template <class T>
+std::size_t convertPointSet(const char *textPath, const char *binaryPath)
+{
+	std::vector<Vector2<T>> points = loadPoints<T>(textPath);
+	writePointSet(binaryPath, points.data(), points.size());
+	return points.size();
+}
+
+// Zero-copy reader: the points are used straight from the memory map
+template <class T>
+class PointSetView
+{
+public:
+	PointSetView(const char *path) : _file(new MappedFile(path)), _points(nullptr), _count(0)
+	{
+		static_assert(sizeof(Vector2<T>) == 2 * sizeof(T), "Vector2 must be two packed coordinates");
+
+		if (_file->size() < sizeof(PointSetHeader)) throw "Not a point set file";
+
+		const PointSetHeader *header = (const PointSetHeader*)_file->data();
+		if (memcmp(header->magic, "SMTP", 4) != 0) throw "Not a point set file";
+		if (header->version != pointSetVersion) throw "Unsupported point set version";
+		if (header->type != coordinateType<T>()) throw "Point set has a different coordinate type";
+		if (header->headerSize < sizeof(PointSetHeader) || header->headerSize % sizeof(T) != 0
+			|| header->headerSize > _file->size()
+			|| (_file->size() - header->headerSize) / sizeof(Vector2<T>) < header->count)
+			throw "Truncated point set file";
+
+		_points = (const Vector2<T>*)(_file->data() + header->headerSize);
+		_count = (std::size_t)header->count;
+	}
+
+	const Vector2<T>* data() const { return _points; }
+	std::size_t size() const { return _count; }
+
+	const Vector2<T>* begin() const { return _points; }
+	const Vector2<T>* end() const { return _points + _count; }
+
+private:
+	std::unique_ptr<MappedFile> _file;
+	const Vector2<T> *_points;
+	std::size_t _count;
+};
+
+#endif
@@ -0,0 +1,733 @@
+#ifndef H_PREDICATES
+#define H_PREDICATES
+
+#include "vector2.h"
+
+#include <utility>
+#include <math.h>
+#include <stdint.h>
+
+// Geometric predicates in the style of Shewchuk's "Adaptive Precision
+// Floating-Point Arithmetic and Fast Robust Geometric Predicates": a plain
+// double evaluation is returned whenever its error bound proves the sign,
+// otherwise progressively more accurate stages follow, the last of them
+// exact, using floating-point expansions. Only the sign of the result is
+// meaningful.
+
+// Error bounds of the fast, intermediate and corrected evaluations, epsilon = 2^-53
+static const double predicateEpsilon = 1.1102230246251565e-16;
+static const double resultErrBound = (3.0 + 8.0 * predicateEpsilon) * predicateEpsilon;
+static const double ccwErrBoundA = (3.0 + 16.0 * predicateEpsilon) * predicateEpsilon;
+static const double ccwErrBoundB = (2.0 + 12.0 * predicateEpsilon) * predicateEpsilon;
+static const double ccwErrBoundC = (9.0 + 64.0 * predicateEpsilon) * predicateEpsilon * predicateEpsilon;
+static const double iccErrBoundA = (10.0 + 96.0 * predicateEpsilon) * predicateEpsilon;
+static const double iccErrBoundB = (4.0 + 48.0 * predicateEpsilon) * predicateEpsilon;
+static const double iccErrBoundC = (44.0 + 576.0 * predicateEpsilon) * predicateEpsilon * predicateEpsilon;
+
+// Expansion arithmetic: a number is an unevaluated sum of non-overlapping
+// doubles, stored in increasing order of magnitude. Expansions live in
+// fixed arrays on the stack, the functions return their length; the
+// predicates below bound every length, so nothing is allocated.
+
+// a + b = x + y exactly, |a| >= |b|
+inline void fastTwoSum(double a, double b, double &x, double &y)
+{
+	x = a + b;
+	y = b - (x - a);
+}
+
+// a + b = x + y exactly
+inline void twoSum(double a, double b, double &x, double &y)
+{
+	x = a + b;
+	double bv = x - a;
+	double av = x - bv;
+	y = (a - av) + (b - bv);
+}
+
+// Roundoff of x = a - b
+inline double twoDiffTail(double a, double b, double x)
+{
+	double bv = a - x;
+	double av = x + bv;
+	return (a - av) + (bv - b);
+}
+
+// a - b = x + y exactly
+inline void twoDiff(double a, double b, double &x, double &y)
+{
+	x = a - b;
+	y = twoDiffTail(a, b, x);
+}
+
+// a * b = x + y exactly
+inline void twoProduct(double a, double b, double &x, double &y)
+{
+	x = a * b;
+	y = fma(a, b, -x);
+}
+
+// (a1 + a0) + (b1 + b0) and (a1 + a0) - (b1 + b0) as four components
+inline void twoTwoSum(double a1, double a0, double b1, double b0, double *x)
+{
+	double i, j, k;
+	twoSum(a0, b0, i, x[0]);
+	twoSum(a1, i, j, k);
+	twoSum(k, b1, i, x[1]);
+	twoSum(j, i, x[3], x[2]);
+}
+
+inline void twoTwoDiff(double a1, double a0, double b1, double b0, double *x)
+{
+	double i, j, k;
+	twoDiff(a0, b0, i, x[0]);
+	twoSum(a1, i, j, k);
+	twoDiff(k, b1, i, x[1]);
+	twoSum(j, i, x[3], x[2]);
+}
+
+// h = e + f, zero components dropped; h holds elen + flen components
+inline int sumExpansion(int elen, const double *e, int flen, const double *f, double *h)
+{
+	double q, qnew, hh;
+	double enow = e[0], fnow = f[0];
+	int eindex = 0, findex = 0, hindex = 0;
+
+	if ((fnow > enow) == (fnow > -enow)) { q = enow; if (++eindex < elen) enow = e[eindex]; }
+	else { q = fnow; if (++findex < flen) fnow = f[findex]; }
+
+	if (eindex < elen && findex < flen)
+	{
+		if ((fnow > enow) == (fnow > -enow)) { fastTwoSum(enow, q, qnew, hh); if (++eindex < elen) enow = e[eindex]; }
+		else { fastTwoSum(fnow, q, qnew, hh); if (++findex < flen) fnow = f[findex]; }
+		q = qnew;
+		if (hh != 0) h[hindex++] = hh;
+
+		while (eindex < elen && findex < flen)
+		{
+			if ((fnow > enow) == (fnow > -enow)) { twoSum(q, enow, qnew, hh); if (++eindex < elen) enow = e[eindex]; }
+			else { twoSum(q, fnow, qnew, hh); if (++findex < flen) fnow = f[findex]; }
+			q = qnew;
+			if (hh != 0) h[hindex++] = hh;
+		}
+	}
+	for (; eindex < elen; eindex++)
+	{
+		twoSum(q, e[eindex], qnew, hh);
+		q = qnew;
+		if (hh != 0) h[hindex++] = hh;
+	}
+	for (; findex < flen; findex++)
+	{
+		twoSum(q, f[findex], qnew, hh);
+		q = qnew;
+		if (hh != 0) h[hindex++] = hh;
+	}
+
+	if (q != 0 || hindex == 0) h[hindex++] = q;
+	return hindex;
+}
+
+// h = e * b, zero components dropped; h holds 2 * elen components
+inline int scaleExpansion(int elen, const double *e, double b, double *h)
+{
+	double q, hh;
+	int hindex = 0;
+	twoProduct(e[0], b, q, hh);
+	if (hh != 0) h[hindex++] = hh;
+	for (int i = 1; i < elen; i++)
+	{
+		double p1, p0, sum;
+		twoProduct(e[i], b, p1, p0);
+		twoSum(q, p0, sum, hh);
+		if (hh != 0) h[hindex++] = hh;
+		fastTwoSum(p1, sum, q, hh);
+		if (hh != 0) h[hindex++] = hh;
+	}
+	if (q != 0 || hindex == 0) h[hindex++] = q;
+	return hindex;
+}
+
+// Approximate value of an expansion
+inline double estimate(int elen, const double *e)
+{
+	double q = e[0];
+	for (int i = 1; i < elen; i++) q += e[i];
+	return q;
+}
+
+// Stages B to D of Shewchuk's orient2dadapt: the determinant of the rounded
+// differences, corrected with their roundoff, then exactly
+inline double orient2dAdapt(double ax, double ay, double bx, double by, double cx, double cy, double detsum)
+{
+	double acx = ax - cx, bcx = bx - cx;
+	double acy = ay - cy, bcy = by - cy;
+
+	double detleft, detlefttail, detright, detrighttail;
+	twoProduct(acx, bcy, detleft, detlefttail);
+	twoProduct(acy, bcx, detright, detrighttail);
+
+	double b[4];
+	twoTwoDiff(detleft, detlefttail, detright, detrighttail, b);
+	double det = estimate(4, b);
+	double errbound = ccwErrBoundB * detsum;
+	if (det >= errbound || -det >= errbound) return det;
+
+	double acxtail = twoDiffTail(ax, cx, acx), bcxtail = twoDiffTail(bx, cx, bcx);
+	double acytail = twoDiffTail(ay, cy, acy), bcytail = twoDiffTail(by, cy, bcy);
+	if (acxtail == 0 && acytail == 0 && bcxtail == 0 && bcytail == 0) return det;
+
+	errbound = ccwErrBoundC * detsum + resultErrBound * fabs(det);
+	det += (acx * bcytail + bcy * acxtail) - (acy * bcxtail + bcx * acytail);
+	if (det >= errbound || -det >= errbound) return det;
+
+	double s1, s0, t1, t0, u[4], c1[8], c2[12], d[16];
+	twoProduct(acxtail, bcy, s1, s0);
+	twoProduct(acytail, bcx, t1, t0);
+	twoTwoDiff(s1, s0, t1, t0, u);
+	int c1length = sumExpansion(4, b, 4, u, c1);
+
+	twoProduct(acx, bcytail, s1, s0);
+	twoProduct(acy, bcxtail, t1, t0);
+	twoTwoDiff(s1, s0, t1, t0, u);
+	int c2length = sumExpansion(c1length, c1, 4, u, c2);
+
+	twoProduct(acxtail, bcytail, s1, s0);
+	twoProduct(acytail, bcxtail, t1, t0);
+	twoTwoDiff(s1, s0, t1, t0, u);
+	int dlength = sumExpansion(c2length, c2, 4, u, d);
+
+	return d[dlength - 1];
+}
+
+// Running sum of the exact incircle stage: fin1 and fin2 take turns
+struct IncircleSum
+{
+	double fin1[1152], fin2[1152];
+	double *now = fin1, *other = fin2;
+	int length = 0;
+
+	void add(int elen, const double *e)
+	{
+		length = sumExpansion(length, now, elen, e, other);
+		std::swap(now, other);
+	}
+};
+
+// The part of incircleadapt's exact stage that one point's tails add:
+// lift tails times the opposite cross product, and the cross product tails
+// times the lift. p is the point (x, y) with tails, q and r the other two
+// in counter-clockwise order, qr their cross product, qq and rr their lifts.
+inline void incircleTailTerms(IncircleSum &fin, double px, double py, double pxtail, double pytail,
+	double qx, double qy, double qxtail, double qytail, double rx, double ry, double rxtail, double rytail,
+	const double *qr, const double *qq, const double *rr)
+{
+	double temp8[8], temp16a[16], temp16b[16], temp16c[16], temp32a[32], temp32b[32], temp48[48], temp64[64];
+	double pxtqr[8], pytqr[8], pxtqrt[16], pytqrt[16], pxtqrtt[8], pytqrtt[8];
+	int pxtqrlen = 0, pytqrlen = 0;
+
+	if (pxtail != 0)
+	{
+		pxtqrlen = scaleExpansion(4, qr, pxtail, pxtqr);
+		int a = scaleExpansion(pxtqrlen, pxtqr, 2 * px, temp16a);
+		int l = scaleExpansion(4, rr, pxtail, temp8);
+		int b = scaleExpansion(l, temp8, qy, temp16b);
+		l = scaleExpansion(4, qq, pxtail, temp8);
+		int c = scaleExpansion(l, temp8, -ry, temp16c);
+		int t = sumExpansion(a, temp16a, b, temp16b, temp32a);
+		fin.add(sumExpansion(c, temp16c, t, temp32a, temp48), temp48);
+	}
+	if (pytail != 0)
+	{
+		pytqrlen = scaleExpansion(4, qr, pytail, pytqr);
+		int a = scaleExpansion(pytqrlen, pytqr, 2 * py, temp16a);
+		int l = scaleExpansion(4, qq, pytail, temp8);
+		int b = scaleExpansion(l, temp8, rx, temp16b);
+		l = scaleExpansion(4, rr, pytail, temp8);
+		int c = scaleExpansion(l, temp8, -qx, temp16c);
+		int t = sumExpansion(a, temp16a, b, temp16b, temp32a);
+		fin.add(sumExpansion(c, temp16c, t, temp32a, temp48), temp48);
+	}
+	if (pxtail == 0 && pytail == 0) return;
+
+	// Tails of the cross product of q and r
+	double qrt[8], qrtt[4];
+	int qrtlen, qrttlen;
+	if (qxtail != 0 || qytail != 0 || rxtail != 0 || rytail != 0)
+	{
+		double ti1, ti0, tj1, tj0, u[4], v[4];
+		twoProduct(qxtail, ry, ti1, ti0);
+		twoProduct(qx, rytail, tj1, tj0);
+		twoTwoSum(ti1, ti0, tj1, tj0, u);
+		twoProduct(rxtail, -qy, ti1, ti0);
+		twoProduct(rx, -qytail, tj1, tj0);
+		twoTwoSum(ti1, ti0, tj1, tj0, v);
+		qrtlen = sumExpansion(4, u, 4, v, qrt);
+
+		twoProduct(qxtail, rytail, ti1, ti0);
+		twoProduct(rxtail, qytail, tj1, tj0);
+		twoTwoDiff(ti1, ti0, tj1, tj0, qrtt);
+		qrttlen = 4;
+	}
+	else
+	{
+		qrt[0] = 0;
+		qrtlen = 1;
+		qrtt[0] = 0;
+		qrttlen = 1;
+	}
+
+	if (pxtail != 0)
+	{
+		int a = scaleExpansion(pxtqrlen, pxtqr, pxtail, temp16a);
+		int pxtqrtlen = scaleExpansion(qrtlen, qrt, pxtail, pxtqrt);
+		int b = scaleExpansion(pxtqrtlen, pxtqrt, 2 * px, temp32a);
+		fin.add(sumExpansion(a, temp16a, b, temp32a, temp48), temp48);
+		if (qytail != 0)
+		{
+			int l = scaleExpansion(4, rr, pxtail, temp8);
+			fin.add(scaleExpansion(l, temp8, qytail, temp16a), temp16a);
+		}
+		if (rytail != 0)
+		{
+			int l = scaleExpansion(4, qq, -pxtail, temp8);
+			fin.add(scaleExpansion(l, temp8, rytail, temp16a), temp16a);
+		}
+
+		a = scaleExpansion(pxtqrtlen, pxtqrt, pxtail, temp32a);
+		int pxtqrttlen = scaleExpansion(qrttlen, qrtt, pxtail, pxtqrtt);
+		int c = scaleExpansion(pxtqrttlen, pxtqrtt, 2 * px, temp16a);
+		int d = scaleExpansion(pxtqrttlen, pxtqrtt, pxtail, temp16b);
+		int e = sumExpansion(c, temp16a, d, temp16b, temp32b);
+		fin.add(sumExpansion(a, temp32a, e, temp32b, temp64), temp64);
+	}
+	if (pytail != 0)
+	{
+		int a = scaleExpansion(pytqrlen, pytqr, pytail, temp16a);
+		int pytqrtlen = scaleExpansion(qrtlen, qrt, pytail, pytqrt);
+		int b = scaleExpansion(pytqrtlen, pytqrt, 2 * py, temp32a);
+		fin.add(sumExpansion(a, temp16a, b, temp32a, temp48), temp48);
+
+		a = scaleExpansion(pytqrtlen, pytqrt, pytail, temp32a);
+		int pytqrttlen = scaleExpansion(qrttlen, qrtt, pytail, pytqrtt);
+		int c = scaleExpansion(pytqrttlen, pytqrtt, 2 * py, temp16a);
+		int d = scaleExpansion(pytqrttlen, pytqrtt, pytail, temp16b);
+		int e = sumExpansion(c, temp16a, d, temp16b, temp32b);
+		fin.add(sumExpansion(a, temp32a, e, temp32b, temp64), temp64);
+	}
+}
+
+// Lift of a point as four components
+inline void incircleLift(double x, double y, double *lift)
+{
+	double x1, x0, y1, y0;
+	twoProduct(x, x, x1, x0);
+	twoProduct(y, y, y1, y0);
+	twoTwoSum(x1, x0, y1, y0, lift);
+}
+
+// Stages B to D of Shewchuk's incircleadapt
+inline double incircleAdapt(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy, double permanent)
+{
+	double adx = ax - dx, bdx = bx - dx, cdx = cx - dx;
+	double ady = ay - dy, bdy = by - dy, cdy = cy - dy;
+
+	// Cross products of the rounded differences, then every point's lift times the opposite one
+	double bc[4], ca[4], ab[4], s1, s0, t1, t0;
+	twoProduct(bdx, cdy, s1, s0);
+	twoProduct(cdx, bdy, t1, t0);
+	twoTwoDiff(s1, s0, t1, t0, bc);
+	twoProduct(cdx, ady, s1, s0);
+	twoProduct(adx, cdy, t1, t0);
+	twoTwoDiff(s1, s0, t1, t0, ca);
+	twoProduct(adx, bdy, s1, s0);
+	twoProduct(bdx, ady, t1, t0);
+	twoTwoDiff(s1, s0, t1, t0, ab);
+
+	auto liftTimes = [](const double *cross, double x, double y, double *det) -> int
+	{
+		double x8[8], xx16[16], y8[8], yy16[16];
+		int xlen = scaleExpansion(4, cross, x, x8);
+		int xxlen = scaleExpansion(xlen, x8, x, xx16);
+		int ylen = scaleExpansion(4, cross, y, y8);
+		int yylen = scaleExpansion(ylen, y8, y, yy16);
+		return sumExpansion(xxlen, xx16, yylen, yy16, det);
+	};
+
+	double adet[32], bdet[32], cdet[32], abdet[64];
+	int alen = liftTimes(bc, adx, ady, adet);
+	int blen = liftTimes(ca, bdx, bdy, bdet);
+	int clen = liftTimes(ab, cdx, cdy, cdet);
+	int ablen = sumExpansion(alen, adet, blen, bdet, abdet);
+
+	IncircleSum fin;
+	fin.length = sumExpansion(ablen, abdet, clen, cdet, fin.now);
+
+	double det = estimate(fin.length, fin.now);
+	double errbound = iccErrBoundB * permanent;
+	if (det >= errbound || -det >= errbound) return det;
+
+	double adxtail = twoDiffTail(ax, dx, adx), adytail = twoDiffTail(ay, dy, ady);
+	double bdxtail = twoDiffTail(bx, dx, bdx), bdytail = twoDiffTail(by, dy, bdy);
+	double cdxtail = twoDiffTail(cx, dx, cdx), cdytail = twoDiffTail(cy, dy, cdy);
+	if (adxtail == 0 && bdxtail == 0 && cdxtail == 0 && adytail == 0 && bdytail == 0 && cdytail == 0) return det;
+
+	errbound = iccErrBoundC * permanent + resultErrBound * fabs(det);
+	det += ((adx * adx + ady * ady) * ((bdx * cdytail + cdy * bdxtail) - (bdy * cdxtail + cdx * bdytail))
+			+ 2.0 * (adx * adxtail + ady * adytail) * (bdx * cdy - bdy * cdx))
+		+ ((bdx * bdx + bdy * bdy) * ((cdx * adytail + ady * cdxtail) - (cdy * adxtail + adx * cdytail))
+			+ 2.0 * (bdx * bdxtail + bdy * bdytail) * (cdx * ady - cdy * adx))
+		+ ((cdx * cdx + cdy * cdy) * ((adx * bdytail + bdy * adxtail) - (ady * bdxtail + bdx * adytail))
+			+ 2.0 * (cdx * cdxtail + cdy * cdytail) * (adx * bdy - ady * bdx));
+	if (det >= errbound || -det >= errbound) return det;
+
+	// Exact: the terms the tails add, point by point
+	double aa[4], bb[4], cc[4];
+	incircleLift(adx, ady, aa);
+	incircleLift(bdx, bdy, bb);
+	incircleLift(cdx, cdy, cc);
+
+	incircleTailTerms(fin, adx, ady, adxtail, adytail, bdx, bdy, bdxtail, bdytail, cdx, cdy, cdxtail, cdytail, bc, bb, cc);
+	incircleTailTerms(fin, bdx, bdy, bdxtail, bdytail, cdx, cdy, cdxtail, cdytail, adx, ady, adxtail, adytail, ca, cc, aa);
+	incircleTailTerms(fin, cdx, cdy, cdxtail, cdytail, adx, ady, adxtail, adytail, bdx, bdy, bdxtail, bdytail, ab, aa, bb);
+
+	return fin.now[fin.length - 1];
+}
+
+// Positive when (a, b, c) turn counter-clockwise, negative when clockwise, zero when collinear
+inline double orient2d(double ax, double ay, double bx, double by, double cx, double cy)
+{
+	double detleft = (ax - cx) * (by - cy);
+	double detright = (ay - cy) * (bx - cx);
+	double det = detleft - detright;
+	double detsum;
+
+	if (detleft > 0)
+	{
+		if (detright <= 0) return det;
+		detsum = detleft + detright;
+	}
+	else if (detleft < 0)
+	{
+		if (detright >= 0) return det;
+		detsum = -detleft - detright;
+	}
+	else
+		return det;
+
+	double errbound = ccwErrBoundA * detsum;
+	if (det >= errbound || -det >= errbound) return det;
+
+	return orient2dAdapt(ax, ay, bx, by, cx, cy, detsum);
+}
+
+// Positive when d lies inside the circle through the counter-clockwise (a, b, c),
+// negative when outside, zero when the four points are cocircular
+inline double incircle(double ax, double ay, double bx, double by, double cx, double cy, double dx, double dy)
+{
+	double adx = ax - dx, ady = ay - dy;
+	double bdx = bx - dx, bdy = by - dy;
+	double cdx = cx - dx, cdy = cy - dy;
+
+	double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+	double alift = adx * adx + ady * ady;
+
+	double cdxady = cdx * ady, adxcdy = adx * cdy;
+	double blift = bdx * bdx + bdy * bdy;
+
+	double adxbdy = adx * bdy, bdxady = bdx * ady;
+	double clift = cdx * cdx + cdy * cdy;
+
+	double det = alift * (bdxcdy - cdxbdy) + blift * (cdxady - adxcdy) + clift * (adxbdy - bdxady);
+
+	double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * alift
+		+ (fabs(cdxady) + fabs(adxcdy)) * blift
+		+ (fabs(adxbdy) + fabs(bdxady)) * clift;
+	double errbound = iccErrBoundA * permanent;
+	if (det > errbound || -det > errbound) return det;
+
+	return incircleAdapt(ax, ay, bx, by, cx, cy, dx, dy, permanent);
+}
+
+template <class T>
+inline double orient2d(const Vector2<T> &a, const Vector2<T> &b, const Vector2<T> &c)
+{
+	return orient2d(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+template <class T>
+inline double incircle(const Vector2<T> &a, const Vector2<T> &b, const Vector2<T> &c, const Vector2<T> &d)
+{
+	return incircle(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+}
+
+// Integer coordinates: the determinants are evaluated exactly in integers,
+// no filter and no expansions. orient2d multiplies the differences in 128
+// bits, comparing magnitudes when they reach 2^63. incircle takes the
+// 128-bit path while the points lie within 2^30 of each other, where every
+// term stays below 2^122. Farther apart (int32 differences reach 2^32) it
+// takes the expansions above, which are exact for any coordinates a double
+// holds: all int32 ones and int64 ones up to 2^53. Beyond that it sums the
+// terms in 320-bit integers. Compilers without __int128 use the
+// floating-point versions, inexact past 2^53.
+#ifdef __SIZEOF_INT128__
+
+// Sign of p * q - r * s for factors below 2^64 in magnitude
+inline double productDifferenceSign(__int128 p, __int128 q, __int128 r, __int128 s)
+{
+	int left = ((p > 0) - (p < 0)) * ((q > 0) - (q < 0));
+	int right = ((r > 0) - (r < 0)) * ((s > 0) - (s < 0));
+	if (left != right) return left > right ? 1.0 : -1.0;
+	if (left == 0) return 0.0;
+
+	unsigned __int128 lp = (unsigned __int128)(p < 0 ? -p : p) * (unsigned __int128)(q < 0 ? -q : q);
+	unsigned __int128 rp = (unsigned __int128)(r < 0 ? -r : r) * (unsigned __int128)(s < 0 ? -s : s);
+	if (lp == rp) return 0.0;
+	return (lp > rp) == (left > 0) ? 1.0 : -1.0;
+}
+
+// True when -2^bits <= a - b < 2^bits
+inline bool differenceWithin(int64_t a, int64_t b, int bits)
+{
+	__int128 d = (__int128)a - b, limit = (__int128)1 << bits;
+	return d >= -limit && d < limit;
+}
+
+inline double orient2dInteger(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy)
+{
+	if (!differenceWithin(ax, cx, 63) || !differenceWithin(ay, cy, 63) || !differenceWithin(bx, cx, 63) || !differenceWithin(by, cy, 63))
+		return productDifferenceSign((__int128)ax - cx, (__int128)by - cy, (__int128)ay - cy, (__int128)bx - cx);
+
+	__int128 det = (__int128)(ax - cx) * (by - cy) - (__int128)(ay - cy) * (bx - cx);
+	return det > 0 ? 1.0 : det < 0 ? -1.0 : 0.0;
+}
+
+// Two's complement integer of 320 bits, arithmetic modulo 2^320: exact for
+// the incircle determinant of any int64 points, below 2^261 in magnitude
+struct WideInteger
+{
+	WideInteger(__int128 v)
+	{
+		w[0] = (uint64_t)v;
+		w[1] = (uint64_t)(v >> 64);
+		w[2] = w[3] = w[4] = v < 0 ? ~(uint64_t)0 : 0;
+	}
+
+	WideInteger operator+(const WideInteger &b) const
+	{
+		WideInteger r(0);
+		unsigned __int128 carry = 0;
+		for (int i = 0; i < 5; i++)
+		{
+			carry += (unsigned __int128)w[i] + b.w[i];
+			r.w[i] = (uint64_t)carry;
+			carry >>= 64;
+		}
+		return r;
+	}
+
+	// a - b = a + ~b + 1
+	WideInteger operator-(const WideInteger &b) const
+	{
+		WideInteger r(0);
+		unsigned __int128 carry = 1;
+		for (int i = 0; i < 5; i++)
+		{
+			carry += (unsigned __int128)w[i] + ~b.w[i];
+			r.w[i] = (uint64_t)carry;
+			carry >>= 64;
+		}
+		return r;
+	}
+
+	WideInteger operator*(const WideInteger &b) const
+	{
+		WideInteger r(0);
+		for (int i = 0; i < 5; i++)
+		{
+			unsigned __int128 carry = 0;
+			for (int j = 0; i + j < 5; j++)
+			{
+				carry += (unsigned __int128)w[i] * b.w[j] + r.w[i + j];
+				r.w[i + j] = (uint64_t)carry;
+				carry >>= 64;
+			}
+		}
+		return r;
+	}
+
+	double sign() const
+	{
+		if ((int64_t)w[4] < 0) return -1.0;
+		return (w[0] | w[1] | w[2] | w[3] | w[4]) ? 1.0 : 0.0;
+	}
+
+	uint64_t w[5];
+};
+
+inline double incircleWide(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy, int64_t dx, int64_t dy)
+{
+	WideInteger adx((__int128)ax - dx), ady((__int128)ay - dy);
+	WideInteger bdx((__int128)bx - dx), bdy((__int128)by - dy);
+	WideInteger cdx((__int128)cx - dx), cdy((__int128)cy - dy);
+
+	WideInteger alift = adx * adx + ady * ady;
+	WideInteger blift = bdx * bdx + bdy * bdy;
+	WideInteger clift = cdx * cdx + cdy * cdy;
+
+	WideInteger det = alift * (bdx * cdy - cdx * bdy)
+		+ blift * (cdx * ady - adx * cdy)
+		+ clift * (adx * bdy - bdx * ady);
+	return det.sign();
+}
+
+inline double incircleInteger(int64_t ax, int64_t ay, int64_t bx, int64_t by, int64_t cx, int64_t cy, int64_t dx, int64_t dy)
+{
+	if (!differenceWithin(ax, dx, 30) || !differenceWithin(ay, dy, 30) || !differenceWithin(bx, dx, 30)
+		|| !differenceWithin(by, dy, 30) || !differenceWithin(cx, dx, 30) || !differenceWithin(cy, dy, 30))
+	{
+		// Doubles hold every coordinate up to 2^53 exactly
+		const int64_t exact = (int64_t)1 << 53;
+		if (ax < -exact || ax > exact || ay < -exact || ay > exact || bx < -exact || bx > exact || by < -exact || by > exact
+			|| cx < -exact || cx > exact || cy < -exact || cy > exact || dx < -exact || dx > exact || dy < -exact || dy > exact)
+			return incircleWide(ax, ay, bx, by, cx, cy, dx, dy);
+		return incircle((double)ax, (double)ay, (double)bx, (double)by, (double)cx, (double)cy, (double)dx, (double)dy);
+	}
+
+	int64_t adx = ax - dx, ady = ay - dy;
+	int64_t bdx = bx - dx, bdy = by - dy;
+	int64_t cdx = cx - dx, cdy = cy - dy;
+
+	// Every product below 2^61, every term below 2^122
+	int64_t alift = adx * adx + ady * ady;
+	int64_t blift = bdx * bdx + bdy * bdy;
+	int64_t clift = cdx * cdx + cdy * cdy;
+
+	__int128 det = (__int128)alift * (bdx * cdy - cdx * bdy)
+		+ (__int128)blift * (cdx * ady - adx * cdy)
+		+ (__int128)clift * (adx * bdy - bdx * ady);
+	return det > 0 ? 1.0 : det < 0 ? -1.0 : 0.0;
+}
+
+inline double orient2d(const Vector2<int32_t> &a, const Vector2<int32_t> &b, const Vector2<int32_t> &c)
+{
+	return orient2dInteger(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+inline double orient2d(const Vector2<int64_t> &a, const Vector2<int64_t> &b, const Vector2<int64_t> &c)
+{
+	return orient2dInteger(a.x, a.y, b.x, b.y, c.x, c.y);
+}
+
+inline double incircle(const Vector2<int32_t> &a, const Vector2<int32_t> &b, const Vector2<int32_t> &c, const Vector2<int32_t> &d)
+{
+	return incircleInteger(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+}
+
+inline double incircle(const Vector2<int64_t> &a, const Vector2<int64_t> &b, const Vector2<int64_t> &c, const Vector2<int64_t> &d)
+{
+	return incircleInteger(a.x, a.y, b.x, b.y, c.x, c.y, d.x, d.y);
+}
+
+#endif
+
+// Symbolic super triangle: Bowyer-Watson starts from a triangle around
+// every input point. A finite one needs coordinates beyond the input, which
+// integer types may not hold, so its corners are symbolic instead:
+// (-2M, -M^2), (3M, -M^2) and (M, M^2) in counter-clockwise order, for M
+// growing without bound. The predicates below return the sign each test
+// takes for all large enough M, found from comparisons of the real
+// coordinates and the real predicates; the corner coordinates are never
+// read. A corner is given as 0, 1 or 2, a real point as -1.
+
+// Sign of a - b
+template <class T>
+inline double compareCoordinates(T a, T b)
+{
+	return a > b ? 1.0 : a < b ? -1.0 : 0.0;
+}
+
+// Real points to the front, then the corners in increasing order; returns
+// the sign of the permutation
+template <class T>
+inline double sortCorners(const Vector2<T> **p, int *corner, int n)
+{
+	double sign = 1;
+	for (int i = 1; i < n; i++)
+		for (int j = i; j > 0 && corner[j - 1] > corner[j]; j--)
+		{
+			std::swap(p[j - 1], p[j]);
+			std::swap(corner[j - 1], corner[j]);
+			sign = -sign;
+		}
+	return sign;
+}
+
+// orient2d where any of the points may be a corner
+template <class T>
+inline double orient2dSuper(const Vector2<T> &a, int ca, const Vector2<T> &b, int cb, const Vector2<T> &c, int cc)
+{
+	if ((ca & cb & cc) < 0) return orient2d(a, b, c);
+
+	const Vector2<T> *p[3] = { &a, &b, &c };
+	int corner[3] = { ca, cb, cc };
+	double sign = sortCorners(p, corner, 3);
+	const Vector2<T> &u = *p[0], &v = *p[1];
+
+	if (corner[1] >= 0)
+	{
+		// Two or three corners: a real point sees any two of them in a fixed turn
+		if (corner[0] >= 0 || corner[1] != 0 || corner[2] != 2) return sign;
+		return -sign;
+	}
+
+	// The corner is far below (0 and 1, slightly left and right) or far above (2)
+	double s = corner[2] == 2 ? compareCoordinates(v.x, u.x) : compareCoordinates(u.x, v.x);
+	if (s == 0) s = corner[2] == 0 ? compareCoordinates(v.y, u.y) : compareCoordinates(u.y, v.y);
+	return sign * s;
+}
+
+// incircle where any of the points may be a corner
+template <class T>
+inline double incircleSuper(const Vector2<T> &a, int ca, const Vector2<T> &b, int cb, const Vector2<T> &c, int cc, const Vector2<T> &d, int cd)
+{
+	if ((ca & cb & cc & cd) < 0) return incircle(a, b, c, d);
+
+	const Vector2<T> *p[4] = { &a, &b, &c, &d };
+	int corner[4] = { ca, cb, cc, cd };
+	double sign = sortCorners(p, corner, 4);
+	const Vector2<T> &u = *p[0], &v = *p[1], &w = *p[2];
+
+	// Three corners: the real point is inside their circle
+	if (corner[1] >= 0) return -sign;
+
+	// Two corners: the circle through them and u, v is nearly the line uv,
+	// the corners decide which side of it is inside
+	if (corner[2] >= 0)
+	{
+		double s;
+		if (corner[3] == 1)
+		{
+			s = compareCoordinates(u.y, v.y);
+			if (s == 0) s = compareCoordinates(v.x, u.x);
+		}
+		else
+		{
+			s = compareCoordinates(v.x, u.x);
+			if (s == 0) s = corner[2] == 0 ? compareCoordinates(u.y, v.y) : compareCoordinates(v.y, u.y);
+		}
+		return sign * s;
+	}
+
+	// One corner: it is outside the circle through u, v and w, unless those
+	// are collinear and the circle is the line: then w inside the segment
+	// uv puts the corner side outside, w beyond it the corner side inside
+	double o = orient2d(u, v, w);
+	if (o != 0) return o > 0 ? -sign : sign;
+
+	double along = u.x != v.x ? compareCoordinates(w.x, u.x) * compareCoordinates(v.x, w.x)
+		: compareCoordinates(w.y, u.y) * compareCoordinates(v.y, w.y);
+	return -sign * along * orient2dSuper(u, -1, v, -1, w, corner[3]);
+}
+
+#endif
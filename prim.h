@@ -1,15 +1,27 @@
 #ifndef H_PRIM
 #define H_PRIM
 
-#include <iostream>
 #include <stdio.h>
 #include <math.h>
-#include <limits.h>
 
 #include "vector2.h"
 #include "edge.h"
 #include "triangle.h"
 #include "delaunay.h"
+#include "mesh.h"
+#include "mst.h"
+#include "greedy.h"
+#include "exact.h"
+#include "dynamicmst.h"
+#include "profile.h"
+#include "solution.h"
+
+// How shortestPath searches the subsets of the candidates
+enum class SearchMode
+{
+	GrayCode,		// Every subset, one DynamicMST update per step
+	BranchAndBound	// Subset tree pruned by the Steiner ratio, seeded with the greedy tree
+};
 
 template <class T>
 class Prim
@@ -18,212 +30,82 @@ public:
 	using TriangleType = Triangle<T>;
 	using VertexType = Vector2<T>;
 	
-	// Only for testing execution time of Prim algorithm, doesn't give final solution of SMT problem
-	const float testTime(std::vector<VertexType>& vertices, std::vector<VertexType>& steinerpoints) {
-		float min = FLT_MAX; int n;
-		std::vector<float> results;
-		std::vector<std::vector<int>> bin;
-
-		std::vector<Vector2<float>> randPoints;
-
-		for (int j = 0; j < vertices.size(); j++)
-			randPoints.push_back(vertices[j]);
-
-		std::vector<std::vector<float>> adjMatrix = getAdjMatrix(randPoints);
-		return primMST(adjMatrix, 0);
+	// Terminals are the vertices of the triangulation
+	const float shortestPath(const Mesh<T> &mesh, std::vector<VertexType> &steinerpoints)
+	{
+		return shortestPath(mesh.vertices, steinerpoints);
 	}
 
-	const float shortestPath(std::vector<VertexType> &vertices, std::vector<VertexType> &steinerpoints)
+	const float shortestPath(const std::vector<VertexType> &vertices, std::vector<VertexType> &steinerpoints)
 	{
-		float min = FLT_MAX; int n;
-		std::vector<float> results;
-		std::vector<std::vector<int>> bin; 
-		
-		// Lexicographic binary order for N Ferma points
-		for (int i = 0; i < pow(2, steinerpoints.size()); i++)
-		{
-			char p[1024]; 
-			_itoa_s(binary(i), p, 10);
-			std::vector<int> temp;
-			for (int j = 0; j < steinerpoints.size(); j++)
-			{
-				char s = p[j];
-				temp.push_back(atoi(&s));
-			}
-			bin.push_back(temp);
-		}
-		
-		// Bruteforce
-		for (int i = 0; i < pow(2, steinerpoints.size()); i++)
-		{
-			std::vector<Vector2<float>> randPoints;
-			for (auto &v : vertices) randPoints.push_back(v);
-			for (int j = 0; j < steinerpoints.size(); j++)
-			{
-				if (bin[i][j] == 1)
-					randPoints.push_back(steinerpoints[j]);
-			}
-			std::vector<std::vector<float>> adjMatrix = getAdjMatrix(randPoints);
-			results.push_back(primMST(adjMatrix, 0));
-		}
-		
-		// Finding best result
-		for (int i = 0; i < results.size(); i++)
-		{
-			if (results[i] < min) { min = results[i]; n = i; }
-		}
+		PROFILE_SCOPE("Prim::shortestPath");
 
-		// Show and return best result
-		//std::cout << std::endl << "Best additional points:" << std::endl;
-		std::vector<Vector2<float>> randPoints;
-		
-		for (auto &v : vertices) randPoints.push_back(v);
-		for (int j = 0; j < steinerpoints.size(); j++)
-		{
-			if (bin[n][j] == 1) {
-				randPoints.push_back(steinerpoints[j]);
-				//std::cout << "x " << steinerpoints[j].x << " y " << steinerpoints[j].y << std::endl;
-			}
-		}
-		std::vector<std::vector<float>> adjMatrix = getAdjMatrix(randPoints);
+		// 2^k subsets are out of reach past a few dozen candidates
+		if (steinerpoints.size() > _exactLimit) return greedyPath(vertices, steinerpoints);
 
-		std::cout << "Points, included in SMT: " << std::endl;
-		for (int j = 0; j < randPoints.size(); j++)
+		uint64_t best = 0;
+		if (_mode == SearchMode::GrayCode)
+			best = _grayCode.solve(vertices, steinerpoints);
+		else
 		{
-			std::cout << "#" << j+1 << "| x: " << randPoints[j].x << " | y: " << randPoints[j].y << " |" << std::endl;
-		}
+			// The greedy tree gives the exact search a good first incumbent
+			_greedy.solve(vertices, steinerpoints);
+			uint64_t initial = 0;
+			for (auto c = begin(_greedy.getChosen()); c != end(_greedy.getChosen()); c++)
+				initial |= (uint64_t)1 << *c;
 
-		primMST(adjMatrix, 1);
-		return results[n];	
-	}
+			best = _exact.solve(vertices, steinerpoints, initial);
+		}
 
-	const std::vector<std::vector<float>> getAdjMatrix(std::vector<VertexType> &vertices)
-	{
-		std::vector<std::vector<float>> data;
-		
-		for (int i = 0; i < vertices.size(); i++)
+		// Keep and return best result
+		_solution.points.assign(begin(vertices), end(vertices));
+		for (std::size_t j = 0; j < steinerpoints.size(); j++)
 		{
-			std::vector<float> temp;
-			for (int j = 0; j < vertices.size(); j++)
-			{
-				if (i == j)
-				{ 
-					temp.push_back(0); 
-				}
-				else
-				{
-					float f = l(vertices[i], vertices[j]);
-					temp.push_back(f);
-				}
-			}
-			data.push_back(std::vector<float>(temp));
+			if (best >> j & 1)
+				_solution.points.push_back(steinerpoints[j]);
 		}
 
-		return data;
+		_solution.length = _mst.build(_solution.points);
+		_solution.tree = _mst.getTree();
+		_solution.optimal = true;
+		return _solution.length;
 	}
 
-	const float l(VertexType &v1, VertexType &v2)
+	// Polynomial-time mode: greedy incremental insertion of the candidates
+	const float greedyPath(const std::vector<VertexType> &vertices, std::vector<VertexType> &steinerpoints)
 	{
-		return sqrt(pow((v2.x - v1.x), 2) + pow((v2.y - v1.y), 2));
+		_solution.length = _greedy.solve(vertices, steinerpoints);
+		_solution.points = _greedy.getPoints();
+		_solution.tree = _greedy.getTree();
+		_solution.optimal = false;
+		return _solution.length;
 	}
 
-	// Function to find the vertex with minimum key value, from the set 
-	// of vertices not yet included in MST
-	int minKey(std::vector<float> &key, std::vector<bool> &mstSet, std::vector<std::vector<float>> &graph)
-	{
-		// Initialize min value
-		float min = FLT_MAX;
-		int min_index = INT_MIN;
-
-		omp_set_num_threads(2);
-		#pragma omp parallel for // Using OpenMP
-		for (int v = 0; v < graph.size(); v++) {
-			if (mstSet[v] == false && key[v] < min)
-				min = key[v], min_index = v;
-		}
-
-		return min_index;
-	}
+	// Tree found by the last shortestPath or greedyPath; nothing is printed
+	// while solving, pass it to a SolutionWriter to output it
+	const SteinerSolution<T>& getSolution() const { return _solution; }
 
-	// Function to print the constructed MST stored in parent[]
-	const float Solution(std::vector<int> &parent, std::vector<std::vector<float>> &graph, int n) 
+	// Euclidean MST over the Delaunay edges of the points, O(n log n)
+	float delaunayMST(const std::vector<VertexType> &vertices)
 	{
-		float summary = 0;
-		if (n == 1)
-		{
-			printf("\nSolution: \n");
-			printf("Path         Length\n");
-			for (int i = 1; i < graph.size(); i++)
-			{
-				printf("#%d <-> #%d    %.2lf \n", parent[i] + 1, i + 1, graph[i][parent[i]]);
-				summary = summary + graph[i][parent[i]];
-			}
-			printf("Summary: %.2lf \n", summary);
-			return summary;
-		}
-		if (n == 0)
-		{
-			for (int i = 1; i < graph.size(); i++)
-			{
-				summary = summary + graph[i][parent[i]];
-			}
-			return summary;
-		}
+		return _mst.build(vertices);
 	}
 
-	// Function to construct MST
-	float primMST(std::vector<std::vector<float>> &graph, int n)
-	{
-		std::vector<int> parent; // Array to store constructed MST
-		std::vector<float> key; // Key values used to pick minimum weight edge in cut
-		std::vector<bool> mstSet; // To represent set of vertices not yet included in MST
-
-		// Initialize all keys as INFINITE
-		for (int i = 0; i < graph[0].size(); i++)
-		{
-			key.push_back(FLT_MAX);
-			mstSet.push_back(false);
-			parent.push_back(0);
-		}
-
-		// Always include first 1st vertex in MST
-		key[0] = 0;     // Make key 0 so that this vertex is picked as first vertex
-		parent[0] = -1; // First node is always root of MST
+	const std::vector<IndexEdge>& getTree() const { return _mst.getTree(); }
 
-		for (int count = 0; count < graph.size() - 1; count++)
-		{
-			int u = 0;
-			// Pick the minimum key vertex from the set of vertices
-			// not yet included in MST 	
-			u = minKey(key, mstSet, graph);
-				// Add the picked vertex to the MST Set
-				mstSet[u] = true;
-
-				// Update the key only if graph[u][v] is smaller than key[v]
-				for (int v = 0; v < graph.size(); v++)
-					if (graph[u][v] && mstSet[v] == false && graph[u][v] < key[v])
-						parent[v] = u, key[v] = graph[u][v];
-		}
-
-		// Print the constructed MST
-		if (n == 1) return Solution(parent, graph, 1);
-		if (n == 0) return Solution(parent, graph, 0);
-	}
-	
-	int binary(int num)
-	{
-		int t = 0, d = 1;
-		while (num)
-		{
-			t += (num % 2)*d;
-			num = num / 2;
-			d = d * 10;
-		}
-		return t;
-	}
+	// Largest candidate set searched exactly by shortestPath (at most 64)
+	void setExactLimit(std::size_t limit) { _exactLimit = std::min(limit, ExactSteiner<T>::maxCandidates); }
+	void setSearchMode(SearchMode mode) { _mode = mode; }
+	SearchMode getSearchMode() const { return _mode; }
 
 private:
-	std::vector<VertexType> _vertices;
+	EuclideanMST<T> _mst;
+	GreedySteiner<T> _greedy;
+	ExactSteiner<T> _exact;
+	GrayCodeSteiner<T> _grayCode;
+	SteinerSolution<T> _solution;
+	SearchMode _mode = SearchMode::GrayCode;
+	std::size_t _exactLimit = 20;
 };
 
 #endif 
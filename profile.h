@@ -0,0 +1,231 @@
+#ifndef H_PROFILE
+#define H_PROFILE
+
+// Hot-path counters and per-stage timings. Everything here is compiled out
+// unless SMT_PROFILE is defined; the macros then expand to nothing.
+//
+//	PROFILE_COUNT(Counter)			one event
+//	PROFILE_ADD(Counter, value)		a value (count, sum and max are kept)
+//	PROFILE_SCOPE("stage")			times the enclosing block, records peak memory
+//	PROFILE_WRITE(json, trace)		summary as JSON, scopes as a Chrome trace
+//									(chrome://tracing or ui.perfetto.dev)
+
+#ifdef SMT_PROFILE
+
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <chrono>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+class Profile
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	enum Counter
+	{
+		IncircleTests,			// Delaunay::triangulate
+		CavitySize,				// Triangles removed per inserted point, sum = all removed
+		SteinerTriangles,		// Steiner candidate generation
+		SteinerPoints,			// Triangles with a Fermat point
+		WideTriangles,			// Triangles with an angle >= 120 degrees
+		DegenerateTriangles,	// Collinear or coincident vertices
+		SubsetsEvaluated,		// Exact and Gray-code searches
+		SubsetsPruned,
+		MstRelaxations,			// Key updates in the subset MSTs
+		DynamicInserts,			// DynamicMST updates
+		DynamicRemoves,
+		CounterCount
+	};
+
+	static Profile& instance()
+	{
+		static Profile profile;
+		return profile;
+	}
+
+	void add(Counter c, uint64_t value)
+	{
+		Stat &s = _stats[c];
+		s.count.fetch_add(1, std::memory_order_relaxed);
+		s.sum.fetch_add(value, std::memory_order_relaxed);
+		uint64_t max = s.max.load(std::memory_order_relaxed);
+		while (value > max && !s.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+	}
+
+	void record(const char *name, Clock::time_point start, Clock::time_point stop)
+	{
+		Event e;
+		e.name = name;
+		e.start = std::chrono::duration<double, std::micro>(start - _origin).count();
+		e.duration = std::chrono::duration<double, std::micro>(stop - start).count();
+		e.thread = threadId();
+		e.peak = peakMemory();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		_events.push_back(e);
+	}
+
+	// 0 for the first thread that records a scope, then 1, 2, ...
+	static uint64_t threadId()
+	{
+		static std::atomic<uint64_t> next{0};
+		thread_local uint64_t id = next.fetch_add(1, std::memory_order_relaxed);
+		return id;
+	}
+
+	// Peak resident set size of the process in bytes
+	static uint64_t peakMemory()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS pmc;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return (uint64_t)pmc.PeakWorkingSetSize;
+		return 0;
+#else
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+		return (uint64_t)usage.ru_maxrss;
+#else
+		return (uint64_t)usage.ru_maxrss * 1024;
+#endif
+#endif
+	}
+
+	// Counters, and the total time of every stage
+	bool writeJSON(const char *path)
+	{
+		FILE *file = fopen(path, "w");
+		if (!file) return false;
+
+		fprintf(file, "{\n  \"counters\": {\n");
+		for (int c = 0; c < CounterCount; c++)
+		{
+			const Stat &s = _stats[c];
+			fprintf(file, "    \"%s\": {\"count\": %llu, \"sum\": %llu, \"max\": %llu}%s\n", names()[c],
+				(unsigned long long)s.count.load(), (unsigned long long)s.sum.load(), (unsigned long long)s.max.load(),
+				c + 1 < CounterCount ? "," : "");
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::vector<std::string> stages;
+		std::vector<double> totals;
+		std::vector<uint64_t> calls;
+		for (auto e = begin(_events); e != end(_events); e++)
+		{
+			std::size_t i = 0;
+			while (i < stages.size() && stages[i] != e->name) i++;
+			if (i == stages.size()) { stages.push_back(e->name); totals.push_back(0); calls.push_back(0); }
+			totals[i] += e->duration / 1000;
+			calls[i]++;
+		}
+
+		fprintf(file, "  },\n  \"stages\": {\n");
+		for (std::size_t i = 0; i < stages.size(); i++)
+			fprintf(file, "    \"%s\": {\"calls\": %llu, \"ms\": %.3f}%s\n", stages[i].c_str(), (unsigned long long)calls[i],
+				totals[i], i + 1 < stages.size() ? "," : "");
+		fprintf(file, "  },\n  \"peak_memory_bytes\": %llu\n}\n", (unsigned long long)peakMemory());
+
+		fclose(file);
+		return true;
+	}
+
+	// Trace Event Format, one complete ("X") event per scope
+	bool writeTrace(const char *path)
+	{
+		FILE *file = fopen(path, "w");
+		if (!file) return false;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		fprintf(file, "{\"traceEvents\": [\n");
+		for (std::size_t i = 0; i < _events.size(); i++)
+		{
+			const Event &e = _events[i];
+			fprintf(file, "  {\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %llu, "
+				"\"args\": {\"peak_memory_bytes\": %llu}}%s\n", e.name, e.start, e.duration, (unsigned long long)e.thread,
+				(unsigned long long)e.peak, i + 1 < _events.size() ? "," : "");
+		}
+		fprintf(file, "], \"displayTimeUnit\": \"ms\"}\n");
+
+		fclose(file);
+		return true;
+	}
+
+private:
+	struct Stat
+	{
+		std::atomic<uint64_t> count{0}, sum{0}, max{0};
+	};
+
+	struct Event
+	{
+		const char *name;
+		double start, duration;	// Microseconds
+		uint64_t thread;
+		uint64_t peak;
+	};
+
+	static const char* const* names()
+	{
+		static const char *const list[CounterCount] = {
+			"incircle_tests", "cavity_size",
+			"steiner_triangles", "steiner_points", "wide_triangles", "degenerate_triangles",
+			"subsets_evaluated", "subsets_pruned", "mst_relaxations",
+			"dynamic_inserts", "dynamic_removes"
+		};
+		return list;
+	}
+
+	Profile() : _origin(Clock::now()) {}
+
+	Stat _stats[CounterCount];
+	Clock::time_point _origin;
+	std::mutex _mutex;
+	std::vector<Event> _events;
+};
+
+// Times its lifetime
+class ProfileScope
+{
+public:
+	// The profile is created first, its clock origin precedes every scope
+	explicit ProfileScope(const char *name) : _name(name), _start((Profile::instance(), Profile::Clock::now())) {}
+	~ProfileScope() { Profile::instance().record(_name, _start, Profile::Clock::now()); }
+
+private:
+	const char *_name;
+	Profile::Clock::time_point _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#define PROFILE_COUNT(counter) Profile::instance().add(Profile::counter, 1)
+#define PROFILE_ADD(counter, value) Profile::instance().add(Profile::counter, (uint64_t)(value))
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_WRITE(json, trace) (Profile::instance().writeJSON(json), Profile::instance().writeTrace(trace))
+
+#else
+
+#define PROFILE_COUNT(counter) ((void)0)
+#define PROFILE_ADD(counter, value) ((void)0)
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_WRITE(json, trace) ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,213 @@
+#ifndef H_SOLUTION
+#define H_SOLUTION
+
+#include "vector2.h"
+#include "mesh.h"
+#include "pointset.h"
+
+#include <vector>
+#include <charconv>
+#include <system_error>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <type_traits>
+
+// Tree returned by the solvers
+template <class T>
+struct SteinerSolution
+{
+	std::vector<Vector2<T>> points;	// Terminals first, then the Steiner points used
+	std::vector<IndexEdge> tree;	// Edges, indices into points
+	float length = 0;
+	double elapsed = 0;				// Seconds spent in solve()
+	bool optimal = false;			// Best subset of the candidates, proven
+};
+
+enum class OutputFormat
+{
+	Text,		// Points and edges as Prim used to print them
+	Binary		// SolutionHeader, the points, the edges as pairs of uint32
+};
+
+// Binary solution file, little-endian as written by the machine
+struct SolutionHeader
+{
+	char magic[4];			// "SMTS"
+	uint32_t version;
+	uint32_t type;			// Coordinate type, see coordinateType<T>()
+	uint32_t headerSize;	// Offset of the first point
+	uint64_t points;
+	uint64_t edges;
+	double length;
+};
+
+static const uint32_t solutionVersion = 1;
+
+// Serializes solutions through one large buffer: numbers are formatted with
+// std::to_chars straight into it and it goes out with a single fwrite when
+// full, instead of a stream or printf call per value.
+template <class T>
+class SolutionWriter
+{
+public:
+	using VertexType = Vector2<T>;
+
+	explicit SolutionWriter(FILE *file, std::size_t bufferSize = 1 << 20)
+		: _file(file), _buffer(std::max<std::size_t>(bufferSize, 256)), _used(0), _ok(true) {}
+
+	~SolutionWriter() { flush(); }
+
+	SolutionWriter(const SolutionWriter &) = delete;
+	SolutionWriter& operator=(const SolutionWriter &) = delete;
+
+	void write(const SteinerSolution<T> &solution, OutputFormat format)
+	{
+		if (format == OutputFormat::Binary) writeBinary(solution);
+		else writeText(solution);
+	}
+
+	void writeText(const SteinerSolution<T> &solution)
+	{
+		append("Points, included in SMT: \n");
+		for (std::size_t j = 0; j < solution.points.size(); j++)
+		{
+			append("#"); number((uint64_t)j + 1);
+			append("| x: "); coordinate(solution.points[j].x);
+			append(" | y: "); coordinate(solution.points[j].y);
+			append(" |\n");
+		}
+
+		append("\nSolution: \nPath         Length\n");
+		for (auto e = begin(solution.tree); e != end(solution.tree); e++)
+		{
+			append("#"); number((uint64_t)e->a + 1);
+			append(" <-> #"); number((uint64_t)e->b + 1);
+			append("    "); fixed(euclideanLength(solution.points[e->a], solution.points[e->b]));
+			append(" \n");
+		}
+
+		append("Summary: "); fixed(solution.length); append(" \n");
+	}
+
+	void writeBinary(const SteinerSolution<T> &solution)
+	{
+		static_assert(sizeof(VertexType) == 2 * sizeof(T), "Vector2 must be two packed coordinates");
+
+		SolutionHeader header;
+		memcpy(header.magic, "SMTS", 4);
+		header.version = solutionVersion;
+		header.type = coordinateType<T>();
+		header.headerSize = sizeof(SolutionHeader);
+		header.points = solution.points.size();
+		header.edges = solution.tree.size();
+		header.length = solution.length;
+
+		append((const char*)&header, sizeof(header));
+		append((const char*)solution.points.data(), solution.points.size() * sizeof(VertexType));
+		for (auto e = begin(solution.tree); e != end(solution.tree); e++)
+		{
+			uint32_t ab[2] = { e->a, e->b };
+			append((const char*)ab, sizeof(ab));
+		}
+	}
+
+	// False once a write failed
+	bool flush()
+	{
+		if (_used > 0 && _ok) _ok = fwrite(_buffer.data(), 1, _used, _file) == _used;
+		_used = 0;
+		return _ok && fflush(_file) == 0;
+	}
+
+private:
+	static double euclideanLength(const VertexType &a, const VertexType &b)
+	{
+		double dx = (double)b.x - a.x, dy = (double)b.y - a.y;
+		return sqrt(dx * dx + dy * dy);
+	}
+
+	void append(const char *text) { append(text, strlen(text)); }
+
+	void append(const char *data, std::size_t size)
+	{
+		while (size > 0)
+		{
+			if (_used == _buffer.size()) flush();
+			std::size_t n = std::min(size, _buffer.size() - _used);
+			memcpy(_buffer.data() + _used, data, n);
+			_used += n;
+			data += n;
+			size -= n;
+		}
+	}
+
+	// Room for any single number
+	char* reserve()
+	{
+		if (_buffer.size() - _used < 128) flush();
+		return _buffer.data() + _used;
+	}
+
+	// Keeps what to_chars wrote; 128 bytes hold any integer or %g value
+	void commit(std::to_chars_result result)
+	{
+		if (result.ec != std::errc()) throw "Number does not fit the output buffer";
+		_used = result.ptr - _buffer.data();
+	}
+
+	void number(uint64_t value)
+	{
+		commit(std::to_chars(reserve(), _buffer.data() + _buffer.size(), value));
+	}
+
+	// As the stream output did: integers whole, floating-point %g-like
+	void coordinate(T value)
+	{
+		char *first = reserve();
+		char *last = _buffer.data() + _buffer.size();
+		if constexpr (std::is_integral<T>::value)
+			commit(std::to_chars(first, last, value));
+		else
+			commit(std::to_chars(first, last, value, std::chars_format::general, 6));
+	}
+
+	// Two decimals. Past about 1e125 that is longer than reserve() leaves:
+	// retry in the whole buffer, and in %g if even that is too small
+	void fixed(double value)
+	{
+		char *last = _buffer.data() + _buffer.size();
+		std::to_chars_result result = std::to_chars(reserve(), last, value, std::chars_format::fixed, 2);
+		if (result.ec != std::errc())
+		{
+			flush();
+			result = std::to_chars(_buffer.data(), last, value, std::chars_format::fixed, 2);
+		}
+		if (result.ec != std::errc()) result = std::to_chars(_buffer.data(), last, value, std::chars_format::general, 17);
+		commit(result);
+	}
+
+	FILE *_file;
+	std::vector<char> _buffer;
+	std::size_t _used;
+	bool _ok;
+};
+
+// Writes a solution to a file
+template <class T>
+void writeSolution(const char *path, const SteinerSolution<T> &solution, OutputFormat format)
+{
+	FILE *file = fopen(path, format == OutputFormat::Binary ? "wb" : "w");
+	if (!file) throw "Cant open file / Wrong way";
+
+	bool ok;
+	{
+		SolutionWriter<T> writer(file);
+		writer.write(solution, format);
+		ok = writer.flush();
+	}
+
+	if (fclose(file) != 0 || !ok) throw "Cant write file";
+}
+
+#endif
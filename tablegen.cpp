@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdexcept>
+#include <random>
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <omp.h>
+//-----------
+#include "topology.h"
+
+// Topology with its Steiner points renumbered in depth-first order from
+// terminal 0, children by their smallest terminal, edges sorted: equal
+// topologies give equal strings
+static std::string canonicalTopology(const TopologyEdge *edges, std::size_t n)
+{
+	const std::size_t nodes = 2 * n - 2, count = 2 * n - 3;
+	std::vector<std::vector<uint8_t>> adjacent(nodes);
+	for (std::size_t e = 0; e < count; e++)
+	{
+		adjacent[edges[e][0]].push_back(edges[e][1]);
+		adjacent[edges[e][1]].push_back(edges[e][0]);
+	}
+
+	// Smallest terminal below every node, seen from terminal 0
+	std::vector<uint8_t> smallest(nodes, 0xff), parent(nodes, 0xff), order;
+	order.push_back(0);
+	parent[0] = 0;
+	for (std::size_t q = 0; q < order.size(); q++)
+		for (uint8_t v : adjacent[order[q]])
+			if (parent[v] == 0xff) { parent[v] = order[q]; order.push_back(v); }
+	for (std::size_t q = order.size(); q-- > 0;)
+	{
+		uint8_t v = order[q];
+		if (v < n) smallest[v] = v;
+		if (q > 0) smallest[parent[v]] = std::min(smallest[parent[v]], smallest[v]);
+	}
+
+	std::vector<uint8_t> label(nodes);
+	for (std::size_t i = 0; i < n; i++) label[i] = (uint8_t)i;
+	uint8_t next = (uint8_t)n;
+	std::vector<uint8_t> stack(1, 0);
+	while (!stack.empty())
+	{
+		uint8_t v = stack.back();
+		stack.pop_back();
+		if (v >= n) label[v] = next++;
+
+		std::vector<uint8_t> children;
+		for (uint8_t w : adjacent[v])
+			if (w != parent[v] || v == 0) children.push_back(w);
+		std::sort(children.begin(), children.end(), [&smallest](uint8_t a, uint8_t b) { return smallest[a] > smallest[b]; });
+		for (uint8_t w : children) stack.push_back(w);
+	}
+
+	std::vector<std::pair<uint8_t, uint8_t>> relabeled;
+	for (std::size_t e = 0; e < count; e++)
+	{
+		uint8_t a = label[edges[e][0]], b = label[edges[e][1]];
+		relabeled.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+	}
+	std::sort(relabeled.begin(), relabeled.end());
+
+	std::string key;
+	for (auto &e : relabeled) { key.push_back((char)e.first); key.push_back((char)e.second); }
+	return key;
+}
+
+// Random net of the order class: x and y are drawn sorted, y assigned by the
+// ranks the class index encodes
+static void sampleNet(std::size_t n, uint32_t index, std::mt19937 &random, Vector2<double> *points)
+{
+	uint8_t digit[topologyMaxTerminals], rank[topologyMaxTerminals];
+	for (std::size_t i = n; i-- > 0;)
+	{
+		digit[i] = (uint8_t)(index % (n - i));
+		index /= (uint32_t)(n - i);
+	}
+
+	bool used[topologyMaxTerminals] = { false };
+	for (std::size_t i = 0; i < n; i++)
+	{
+		std::size_t r = 0;
+		for (std::size_t skip = digit[i]; used[r] || skip > 0; r++)
+			if (!used[r]) skip--;
+		rank[i] = (uint8_t)r;
+		used[r] = true;
+	}
+
+	std::uniform_real_distribution<double> uniform(0, 1);
+	double x[topologyMaxTerminals], y[topologyMaxTerminals];
+	for (std::size_t i = 0; i < n; i++) { x[i] = uniform(random); y[i] = uniform(random); }
+	std::sort(x, x + n);
+	std::sort(y, y + n);
+	for (std::size_t i = 0; i < n; i++) points[i] = Vector2<double>(x[i], y[rank[i]]);
+}
+
+// One of the 8 symmetries of the square: bit 0 mirrors x, bit 1 mirrors y,
+// bit 2 swaps the axes. They map optimal trees to optimal trees.
+static Vector2<double> symmetry(const Vector2<double> &p, int g)
+{
+	double x = g & 1 ? -p.x : p.x, y = g & 2 ? -p.y : p.y;
+	return g & 4 ? Vector2<double>(y, x) : Vector2<double>(x, y);
+}
+
+// Builds the topology table for SmallNetSteiner: for every order class of
+// every terminal count, random nets of the class are solved exactly
+// (TopologySearch) and the distinct optimal topologies kept as the class's
+// candidates, the most frequent first. Only one class of every symmetry
+// orbit is sampled; its solutions are mirrored into the other classes.
+// Usage: tablegen <output.smtt> [max terminals] [samples per class] [candidates per class]
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		printf("Usage: %s <output.smtt> [max terminals] [samples per class] [candidates per class]\n", argv[0]);
+		return 1;
+	}
+
+	const std::size_t maxTerminals = argc > 2 ? (std::size_t)atoi(argv[2]) : 8;
+	const std::size_t samples = argc > 3 ? (std::size_t)atoi(argv[3]) : 32;
+	const std::size_t keep = argc > 4 ? (std::size_t)atoi(argv[4]) : 16;
+	if (maxTerminals < topologyMinTerminals || maxTerminals > topologyMaxTerminals || samples == 0 || keep == 0)
+	{
+		printf("Max terminals must be %zu..%zu, samples and candidates at least 1\n", topologyMinTerminals, topologyMaxTerminals);
+		return 1;
+	}
+
+	try
+	{
+		TopologyTable table;
+		table.reset(topologyMinTerminals, maxTerminals);
+
+		for (std::size_t n = topologyMinTerminals; n <= maxTerminals; n++)
+		{
+			auto start = std::chrono::steady_clock::now();
+			const uint32_t classes = factorial(n);
+			std::vector<std::vector<std::string>> found(classes);
+
+			#pragma omp parallel for schedule(dynamic, 8)
+			for (int64_t c = 0; c < (int64_t)classes; c++)
+			{
+				std::mt19937 random((uint32_t)(n * 1000003 + c));
+				TopologySearch search;
+				Vector2<double> points[topologyMaxTerminals], mirrored[topologyMaxTerminals];
+				TopologyEdge edges[2 * topologyMaxTerminals - 3], relabeled[2 * topologyMaxTerminals - 3];
+				uint8_t order[topologyMaxTerminals], label[2 * topologyMaxTerminals - 2];
+
+				// The orbit's smallest class samples for all of it
+				bool first = true;
+				sampleNet(n, (uint32_t)c, random, points);
+				for (int g = 1; g < 8 && first; g++)
+				{
+					for (std::size_t i = 0; i < n; i++) mirrored[i] = symmetry(points[i], g);
+					first = orderClass(mirrored, n, order) >= (uint32_t)c;
+				}
+				if (!first) continue;
+
+				for (std::size_t s = 0; s < samples; s++)
+				{
+					sampleNet(n, (uint32_t)c, random, points);
+					if (search.solve(points, n, edges) < 0) continue;
+
+					for (int g = 0; g < 8; g++)
+					{
+						for (std::size_t i = 0; i < n; i++) mirrored[i] = symmetry(points[i], g);
+						uint32_t image = orderClass(mirrored, n, order);
+
+						// Terminals to their canonical index in the mirrored net
+						for (std::size_t i = 0; i < 2 * n - 2; i++) label[i] = (uint8_t)i;
+						for (std::size_t i = 0; i < n; i++) label[order[i]] = (uint8_t)i;
+						for (std::size_t e = 0; e < 2 * n - 3; e++)
+						{
+							relabeled[e][0] = label[edges[e][0]];
+							relabeled[e][1] = label[edges[e][1]];
+						}
+						found[image].push_back(canonicalTopology(relabeled, n));
+					}
+				}
+			}
+
+			// Distinct topologies, then every class's list by frequency
+			TopologyTable::Level &level = table.level(n);
+			std::map<std::string, uint16_t> ids;
+			level.offsets.assign(1, 0);
+			for (uint32_t c = 0; c < classes; c++)
+			{
+				std::map<std::string, std::size_t> frequency;
+				for (const std::string &key : found[c]) frequency[key]++;
+				std::vector<std::pair<std::size_t, std::string>> ranked;
+				for (auto &f : frequency) ranked.push_back(std::make_pair(f.second, f.first));
+				std::stable_sort(ranked.begin(), ranked.end(), [](const std::pair<std::size_t, std::string> &a, const std::pair<std::size_t, std::string> &b) { return a.first > b.first; });
+
+				for (std::size_t k = 0; k < ranked.size() && k < keep; k++)
+				{
+					auto id = ids.find(ranked[k].second);
+					if (id == ids.end())
+					{
+						if (ids.size() > 0xffff) throw "Too many topologies";
+						id = ids.insert(std::make_pair(ranked[k].second, (uint16_t)ids.size())).first;
+					}
+					level.candidates.push_back(id->second);
+				}
+				level.offsets.push_back((uint32_t)level.candidates.size());
+			}
+
+			level.edges.resize(ids.size() * (2 * n - 3));
+			for (auto &id : ids)
+				memcpy(&level.edges[(std::size_t)id.second * (2 * n - 3)], id.first.data(), id.first.size());
+
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			printf("%zu terminals: %u classes, %zu topologies, %.2f candidates per class, %.1f s\n",
+				n, classes, ids.size(), (double)level.candidates.size() / classes, elapsed);
+		}
+
+		table.save(argv[1]);
+		printf("Table written to %s\n", argv[1]);
+	}
+	catch (const char *error)
+	{
+		printf("%s\n", error);
+		return 1;
+	}
+	catch (const std::exception &error)
+	{
+		printf("%s\n", error.what());
+		return 1;
+	}
+
+	return 0;
+}
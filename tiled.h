@@ -0,0 +1,486 @@
+#ifndef H_TILED
+#define H_TILED
+
+#include "vector2.h"
+#include "mesh.h"
+#include "delaunay.h"
+#include "steiner.h"
+#include "mst.h"
+#include "greedy.h"
+#include "anytime.h"
+#include "profile.h"
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdint.h>
+#include <omp.h>
+
+// Steiner tree of a very large terminal set, solved in tiles. The terminals
+// are split (k-d, at the median of the longer side) into tiles of at most
+// setTileSize() terminals. Each tile is solved on its own terminals plus
+// those within a margin around it (triangulation, Fermat candidates,
+// greedy insertion), tiles in parallel. A tile keeps the Steiner points
+// inside it and the edges between points it owns; the pieces are stitched
+// by Kruskal over the edges that crossed a tile border and the MSTs of the
+// points near the borders, one per tile window. Only the tiles being
+// solved hold working data, the rest is the input and the result.
+template <class T>
+class TiledSteiner
+{
+public:
+	using VertexType = Vector2<T>;
+	using Clock = std::chrono::steady_clock;
+
+	// Most terminals per tile, the margin comes on top of it
+	void setTileSize(std::size_t terminals) { _tileSize = std::max<std::size_t>(terminals, 16); }
+	// Margin around a tile, as a fraction of its longer side
+	void setOverlap(double fraction) { _overlap = std::min(std::max(fraction, 0.0), 1.0); }
+
+	const SteinerSolution<T>& solve(const std::vector<VertexType> &terminals)
+	{
+		PROFILE_SCOPE("TiledSteiner::solve");
+		const Clock::time_point start = Clock::now();
+
+		_terminals = &terminals;
+		_result.points.assign(begin(terminals), end(terminals));
+		_result.tree.clear();
+		_result.length = 0;
+		_result.optimal = false;
+
+		split();
+		assign();
+		index(terminals);
+
+		while (_workspaces.size() < (std::size_t)omp_get_max_threads())
+			_workspaces.push_back(std::unique_ptr<Workspace>(new Workspace()));
+		_parts.resize(_tiles.size());
+
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int64_t i = 0; i < (int64_t)_tiles.size(); i++)
+			solveTile(*_workspaces[omp_get_thread_num()], (uint32_t)i);
+
+		stitch();
+
+		_result.elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		return _result;
+	}
+
+	const SteinerSolution<T>& getResult() const { return _result; }
+	std::size_t getTileCount() const { return _tiles.size(); }
+
+private:
+	// Terminals _order[first, last) and the rectangle they were split in
+	struct Tile
+	{
+		double minX, minY, maxX, maxY;
+		double margin;
+		std::size_t first, last;
+	};
+
+	// Edge of a tile tree: terminals by global index, Steiner points by
+	// their index in the tile with steinerFlag set
+	struct TileEdge
+	{
+		uint32_t a, b;
+	};
+
+	// What a tile leaves for the stitching
+	struct Part
+	{
+		std::vector<VertexType> steiner;
+		std::vector<TileEdge> edges;	// Between points the tile owns
+		std::vector<TileEdge> crossing;	// To a terminal of another tile
+	};
+
+	struct Workspace
+	{
+		Delaunay<T> delaunay;
+		Steiner<T> steiner;
+		GreedySteiner<T> greedy;
+		std::vector<VertexType> points, candidates;
+		std::vector<uint32_t> global;
+		std::vector<uint32_t> map;
+		EuclideanMST<T> mst;
+		std::vector<std::pair<double, IndexEdge>> joins;
+	};
+
+	static const uint32_t steinerFlag = 0x80000000u;
+
+	const VertexType& terminal(uint32_t i) const { return (*_terminals)[i]; }
+
+	// k-d split down to tiles of at most _tileSize terminals
+	void split()
+	{
+		const std::vector<VertexType> &p = *_terminals;
+		const std::size_t n = p.size();
+		_order.resize(n);
+		for (std::size_t i = 0; i < n; i++) _order[i] = (uint32_t)i;
+		_tiles.clear();
+		if (n == 0) return;
+
+		Tile all;
+		all.minX = all.maxX = p[0].x;
+		all.minY = all.maxY = p[0].y;
+		for (std::size_t i = 1; i < n; i++)
+		{
+			all.minX = std::min(all.minX, (double)p[i].x); all.maxX = std::max(all.maxX, (double)p[i].x);
+			all.minY = std::min(all.minY, (double)p[i].y); all.maxY = std::max(all.maxY, (double)p[i].y);
+		}
+		all.first = 0;
+		all.last = n;
+		_bounds = all;
+
+		std::vector<Tile> stack(1, all);
+		while (!stack.empty())
+		{
+			Tile t = stack.back();
+			stack.pop_back();
+			if (t.last - t.first <= _tileSize)
+			{
+				t.margin = _overlap * std::max(t.maxX - t.minX, t.maxY - t.minY);
+				_tiles.push_back(t);
+				continue;
+			}
+
+			bool vertical = t.maxX - t.minX >= t.maxY - t.minY;
+			std::size_t middle = t.first + (t.last - t.first) / 2;
+			std::nth_element(begin(_order) + t.first, begin(_order) + middle, begin(_order) + t.last, [&](uint32_t a, uint32_t b) {
+				return vertical ? p[a].x < p[b].x : p[a].y < p[b].y;
+			});
+			double cut = vertical ? p[_order[middle]].x : p[_order[middle]].y;
+
+			Tile low = t, high = t;
+			low.last = high.first = middle;
+			if (vertical) low.maxX = high.minX = cut;
+			else low.maxY = high.minY = cut;
+			stack.push_back(high);
+			stack.push_back(low);
+		}
+	}
+
+	// Tile of every terminal
+	void assign()
+	{
+		_tileOf.resize(_order.size());
+		for (uint32_t t = 0; t < _tiles.size(); t++)
+			for (std::size_t i = _tiles[t].first; i < _tiles[t].last; i++) _tileOf[_order[i]] = t;
+	}
+
+	// Bucket grid over the points (all within the terminals' bounds) for the window queries
+	void index(const std::vector<VertexType> &points)
+	{
+		const std::size_t n = points.size();
+
+		// About four terminals per bucket
+		double w = std::max(_bounds.maxX - _bounds.minX, 1e-9), h = std::max(_bounds.maxY - _bounds.minY, 1e-9);
+		_bucket = std::max(sqrt(w * h * 4.0 / std::max<std::size_t>(n, 1)), 1e-9);
+		_nx = std::min(std::max((int)(w / _bucket) + 1, 1), 16384);
+		_ny = std::min(std::max((int)(h / _bucket) + 1, 1), 16384);
+		_bucket = std::max(w / (_nx - 0.5), h / (_ny - 0.5));
+
+		// Counting sort of the terminals by bucket
+		_start.assign((std::size_t)_nx * _ny + 1, 0);
+		for (std::size_t i = 0; i < n; i++) _start[bucketOf(points[i]) + 1]++;
+		for (std::size_t b = 1; b < _start.size(); b++) _start[b] += _start[b - 1];
+		_buckets.resize(n);
+		std::vector<uint32_t> fill(begin(_start), end(_start) - 1);
+		for (std::size_t i = 0; i < n; i++) _buckets[fill[bucketOf(points[i])]++] = (uint32_t)i;
+	}
+
+	int column(double x) const { return std::min(std::max((int)((x - _bounds.minX) / _bucket), 0), _nx - 1); }
+	int row(double y) const { return std::min(std::max((int)((y - _bounds.minY) / _bucket), 0), _ny - 1); }
+	std::size_t bucketOf(const VertexType &p) const { return (std::size_t)row(p.y) * _nx + column(p.x); }
+
+	// Steiner points belong to the tile whose rectangle holds them; the
+	// rectangles are half-open except at the far sides of the whole set
+	bool inside(const Tile &t, const VertexType &p) const
+	{
+		double x = p.x, y = p.y;
+		return x >= t.minX && (x < t.maxX || t.maxX == _bounds.maxX) && y >= t.minY && (y < t.maxY || t.maxY == _bounds.maxY);
+	}
+
+	// Within half the margin of a border the tile shares with another
+	bool nearBorder(const Tile &t, const VertexType &p) const
+	{
+		double x = p.x, y = p.y, band = t.margin / 2;
+		return (t.minX > _bounds.minX && x - t.minX <= band) || (t.maxX < _bounds.maxX && t.maxX - x <= band)
+			|| (t.minY > _bounds.minY && y - t.minY <= band) || (t.maxY < _bounds.maxY && t.maxY - y <= band);
+	}
+
+	void solveTile(Workspace &w, uint32_t index)
+	{
+		const Tile &t = _tiles[index];
+		Part &part = _parts[index];
+		part.steiner.clear();
+		part.edges.clear();
+		part.crossing.clear();
+
+		// Own terminals first, then those in the margin
+		w.points.clear();
+		w.global.clear();
+		for (std::size_t i = t.first; i < t.last; i++)
+		{
+			w.global.push_back(_order[i]);
+			w.points.push_back(terminal(_order[i]));
+		}
+
+		const double x0 = t.minX - t.margin, x1 = t.maxX + t.margin, y0 = t.minY - t.margin, y1 = t.maxY + t.margin;
+		for (int r = row(y0); r <= row(y1); r++)
+			for (int c = column(x0); c <= column(x1); c++)
+			{
+				std::size_t b = (std::size_t)r * _nx + c;
+				for (uint32_t k = _start[b]; k < _start[b + 1]; k++)
+				{
+					uint32_t g = _buckets[k];
+					const VertexType &p = terminal(g);
+					if (_tileOf[g] == index || p.x < x0 || p.x > x1 || p.y < y0 || p.y > y1) continue;
+					w.global.push_back(g);
+					w.points.push_back(p);
+				}
+			}
+
+		const std::size_t terminals = w.points.size();
+		if (terminals < 2) return;
+
+		const Mesh<T> &mesh = w.delaunay.triangulate(w.points);
+		w.candidates.resize(mesh.triangles.size());
+		w.candidates.resize(w.steiner.additionalVertices(mesh, w.candidates.data(), w.candidates.size()));
+		w.greedy.solve(w.points, w.candidates);
+
+		// Local index -> global terminal, own Steiner point, or ~0 (someone else's)
+		const std::vector<VertexType> &points = w.greedy.getPoints();
+		w.map.resize(points.size());
+		for (std::size_t i = 0; i < terminals; i++) w.map[i] = w.global[i];
+		for (std::size_t i = terminals; i < points.size(); i++)
+		{
+			w.map[i] = ~0u;
+			if (!inside(t, points[i])) continue;
+			w.map[i] = (uint32_t)part.steiner.size() | steinerFlag;
+			part.steiner.push_back(points[i]);
+		}
+
+		const std::size_t own = t.last - t.first;
+		const std::vector<IndexEdge> &tree = w.greedy.getTree();
+		for (auto e = begin(tree); e != end(tree); e++)
+		{
+			uint32_t a = w.map[e->a], b = w.map[e->b];
+			if (a == ~0u || b == ~0u) continue;
+			bool ownA = e->a < own || e->a >= terminals, ownB = e->b < own || e->b >= terminals;
+			if (ownA && ownB) part.edges.push_back(TileEdge{ a, b });
+			else if (ownA || ownB) part.crossing.push_back(TileEdge{ a, b });
+		}
+	}
+
+	void stitch()
+	{
+		const std::size_t n = _terminals->size();
+
+		// Global numbering: terminals, then the Steiner points tile by tile
+		std::vector<uint32_t> offset(_parts.size() + 1, (uint32_t)n);
+		for (std::size_t t = 0; t < _parts.size(); t++) offset[t + 1] = offset[t] + (uint32_t)_parts[t].steiner.size();
+		std::vector<VertexType> &points = _result.points;
+		_owner.resize(offset.back());
+		for (std::size_t t = 0; t < _parts.size(); t++)
+		{
+			points.insert(end(points), begin(_parts[t].steiner), end(_parts[t].steiner));
+			for (uint32_t i = offset[t]; i < offset[t + 1]; i++) _owner[i] = (uint32_t)t;
+		}
+		for (std::size_t i = 0; i < n; i++) _owner[i] = _tileOf[i];
+
+		auto global = [&](std::size_t t, uint32_t v) { return v & steinerFlag ? offset[t] + (v & ~steinerFlag) : v; };
+		const std::size_t count = points.size();
+		_set.reset(count);
+		std::vector<IndexEdge> tree;
+
+		// The tile trees are kept whole, the edges that left a tile compete
+		// with the stitching edges below
+		std::vector<std::pair<double, IndexEdge>> joins;
+		for (std::size_t t = 0; t < _parts.size(); t++)
+		{
+			for (auto e = begin(_parts[t].edges); e != end(_parts[t].edges); e++)
+			{
+				uint32_t a = global(t, e->a), b = global(t, e->b);
+				if (_set.unite(a, b)) tree.push_back(IndexEdge(a, b));
+			}
+			for (auto e = begin(_parts[t].crossing); e != end(_parts[t].crossing); e++)
+			{
+				uint32_t a = global(t, e->a), b = global(t, e->b);
+				joins.push_back(std::make_pair(EuclideanMST<T>::length(points[a], points[b]), IndexEdge(a, b)));
+			}
+			_parts[t] = Part();
+		}
+
+		// One tile is one tree already
+		if (_tiles.size() < 2)
+		{
+			prune(tree, n);
+			return;
+		}
+
+		// Stitching points: those near an inner border, and all of any piece
+		// that has none (it would be cut off otherwise)
+		_band.resize(count);
+		_stitch.resize(count);
+		std::vector<char> reached(count, 0);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			_band[i] = nearBorder(_tiles[_owner[i]], points[i]);
+			if (_band[i]) reached[_set.find(i)] = 1;
+		}
+		for (uint32_t i = 0; i < count; i++) _stitch[i] = _band[i] || !reached[_set.find(i)];
+		reached = std::vector<char>();
+
+		// MST of the stitching points of every tile window, own points and
+		// the border points of the neighbours within the margin
+		index(points);
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int64_t i = 0; i < (int64_t)_tiles.size(); i++)
+			stitchTile(*_workspaces[omp_get_thread_num()], (uint32_t)i);
+
+		for (auto w = begin(_workspaces); w != end(_workspaces); w++)
+		{
+			joins.insert(end(joins), begin((*w)->joins), end((*w)->joins));
+			(*w)->joins = std::vector<std::pair<double, IndexEdge>>();
+		}
+
+		std::sort(begin(joins), end(joins), [](const std::pair<double, IndexEdge> &x, const std::pair<double, IndexEdge> &y) {
+			return x.first < y.first;
+		});
+		for (auto j = begin(joins); j != end(joins); j++)
+			if (_set.unite(j->second.a, j->second.b)) tree.push_back(j->second);
+
+		prune(tree, n);
+	}
+
+	void stitchTile(Workspace &w, uint32_t index)
+	{
+		const Tile &t = _tiles[index];
+		const std::vector<VertexType> &points = _result.points;
+		w.points.clear();
+		w.global.clear();
+
+		const double x0 = t.minX - t.margin, x1 = t.maxX + t.margin, y0 = t.minY - t.margin, y1 = t.maxY + t.margin;
+		for (int r = row(y0); r <= row(y1); r++)
+			for (int c = column(x0); c <= column(x1); c++)
+			{
+				std::size_t b = (std::size_t)r * _nx + c;
+				for (uint32_t k = _start[b]; k < _start[b + 1]; k++)
+				{
+					uint32_t g = _buckets[k];
+					const VertexType &p = points[g];
+					if (!_stitch[g] || p.x < x0 || p.x > x1 || p.y < y0 || p.y > y1) continue;
+					if (_owner[g] != index && !_band[g]) continue;
+					w.global.push_back(g);
+					w.points.push_back(p);
+				}
+			}
+
+		w.mst.build(w.points);
+		const std::vector<IndexEdge> &mst = w.mst.getTree();
+		for (auto e = begin(mst); e != end(mst); e++)
+		{
+			uint32_t a = w.global[e->a], b = w.global[e->b];
+			w.joins.push_back(std::make_pair(EuclideanMST<T>::length(points[a], points[b]), IndexEdge(a, b)));
+		}
+	}
+
+	// Steiner points that the stitching left with degree <= 2 only lengthen
+	// the tree: removed, their neighbours joined directly (which keeps the
+	// degrees of the others, so the adjacency is a flat array). Then the
+	// points are compacted.
+	void prune(std::vector<IndexEdge> &tree, std::size_t terminals)
+	{
+		std::vector<VertexType> &points = _result.points;
+		const std::size_t count = points.size();
+		std::vector<uint32_t> first(count + 1, 0), degree(count, 0);
+		for (auto e = begin(tree); e != end(tree); e++) { first[e->a + 1]++; first[e->b + 1]++; }
+		for (std::size_t i = 0; i < count; i++) first[i + 1] += first[i];
+		std::vector<uint32_t> adjacency(first.back());
+		for (auto e = begin(tree); e != end(tree); e++)
+		{
+			adjacency[first[e->a] + degree[e->a]++] = e->b;
+			adjacency[first[e->b] + degree[e->b]++] = e->a;
+		}
+		tree = std::vector<IndexEdge>();
+
+		// In the list of a, b becomes c (or goes if c is ~0)
+		auto replace = [&](uint32_t a, uint32_t b, uint32_t c) {
+			uint32_t *list = &adjacency[first[a]];
+			uint32_t i = 0;
+			while (list[i] != b) i++;
+			if (c != ~0u) list[i] = c;
+			else list[i] = list[--degree[a]];
+		};
+
+		std::vector<char> alive(count, 1);
+		std::vector<uint32_t> work;
+		for (uint32_t s = (uint32_t)terminals; s < count; s++) work.push_back(s);
+		while (!work.empty())
+		{
+			uint32_t s = work.back();
+			work.pop_back();
+			if (!alive[s] || degree[s] > 2) continue;
+
+			const uint32_t *n = &adjacency[first[s]];
+			if (degree[s] == 2)
+			{
+				replace(n[0], s, n[1]);
+				replace(n[1], s, n[0]);
+			}
+			else if (degree[s] == 1)
+				replace(n[0], s, ~0u);
+			for (uint32_t k = 0; k < degree[s]; k++)
+				if (n[k] >= terminals) work.push_back(n[k]);
+
+			degree[s] = 0;
+			alive[s] = 0;
+		}
+
+		std::vector<uint32_t> index(count);
+		std::size_t kept = 0;
+		for (std::size_t i = 0; i < count; i++)
+		{
+			index[i] = (uint32_t)kept;
+			if (alive[i]) points[kept++] = points[i];
+		}
+
+		double length = 0;
+		for (uint32_t a = 0; a < count; a++)
+			for (uint32_t k = 0; k < degree[a]; k++)
+			{
+				uint32_t b = adjacency[first[a] + k];
+				if (a > b) continue;
+				tree.push_back(IndexEdge(index[a], index[b]));
+				length += EuclideanMST<T>::length(points[index[a]], points[index[b]]);
+			}
+
+		points.resize(kept);
+		_result.tree.swap(tree);
+		_result.length = (float)length;
+	}
+
+	std::size_t _tileSize = 50000;
+	double _overlap = 0.1;
+
+	const std::vector<VertexType> *_terminals = nullptr;
+	std::vector<uint32_t> _order, _tileOf;
+	std::vector<Tile> _tiles;
+	Tile _bounds;
+
+	// Terminals by bucket, _buckets[_start[b], _start[b + 1])
+	double _bucket = 1;
+	int _nx = 1, _ny = 1;
+	std::vector<uint32_t> _start, _buckets;
+
+	std::vector<std::unique_ptr<Workspace>> _workspaces;
+	std::vector<Part> _parts;
+	DisjointSet _set;
+	std::vector<uint32_t> _owner;		// Tile of every result point
+	std::vector<char> _band, _stitch;
+	SteinerSolution<T> _result;
+};
+
+#endif
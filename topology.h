@@ -0,0 +1,686 @@
+#ifndef H_TOPOLOGY
+#define H_TOPOLOGY
+
+#include "vector2.h"
+#include "mesh.h"
+#include "solution.h"
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+// Full Steiner topologies of small nets. A topology of n terminals has n - 2
+// Steiner points of degree 3 and 2n - 3 edges; nodes 0..n-1 are the
+// terminals, nodes n.. the Steiner points. Degenerate trees (a Steiner point
+// on a terminal or on another Steiner point) are full topologies whose
+// embedding collapses an edge, so every Steiner tree is one of them.
+
+static const std::size_t topologyMinTerminals = 3;
+static const std::size_t topologyMaxTerminals = 9;
+
+// Edge between two nodes of a topology
+struct TopologyEdge
+{
+	uint8_t& operator[](std::size_t i) { return v[i]; }
+	uint8_t operator[](std::size_t i) const { return v[i]; }
+
+	uint8_t v[2];
+};
+
+// Canonical order of a small net: terminals sorted by x (then y). The class
+// is the rank of the permutation that sorts them by y (then x), 0..n!-1.
+// order[i] is the input index of the i-th terminal in canonical order.
+template <class T>
+uint32_t orderClass(const Vector2<T> *points, std::size_t n, uint8_t *order)
+{
+	uint8_t byY[topologyMaxTerminals], rank[topologyMaxTerminals];
+	for (std::size_t i = 0; i < n; i++) order[i] = byY[i] = (uint8_t)i;
+
+	std::sort(order, order + n, [points](uint8_t a, uint8_t b) {
+		return points[a].x < points[b].x || (points[a].x == points[b].x && points[a].y < points[b].y);
+	});
+	std::sort(byY, byY + n, [points](uint8_t a, uint8_t b) {
+		return points[a].y < points[b].y || (points[a].y == points[b].y && points[a].x < points[b].x);
+	});
+	for (std::size_t i = 0; i < n; i++) rank[byY[i]] = (uint8_t)i;
+
+	// Lehmer code of the y ranks in x order
+	uint32_t index = 0;
+	for (std::size_t i = 0; i < n; i++)
+	{
+		uint32_t smaller = 0;
+		for (std::size_t j = i + 1; j < n; j++)
+			smaller += rank[order[j]] < rank[order[i]];
+		index = index * (uint32_t)(n - i) + smaller;
+	}
+	return index;
+}
+
+inline uint32_t factorial(std::size_t n)
+{
+	uint32_t f = 1;
+	for (std::size_t i = 2; i <= n; i++) f *= (uint32_t)i;
+	return f;
+}
+
+// Number of full topologies of n terminals, (2n - 5)!!
+inline uint32_t fullTopologies(std::size_t n)
+{
+	uint32_t f = 1;
+	for (std::size_t i = 3; i + 5 <= 2 * n; i += 2) f *= (uint32_t)i;
+	return f;
+}
+
+// Shortest embedding of a full topology with the terminals fixed, by
+// Smith's iteration: with the edge weights 1 / length frozen, the Steiner
+// points solve a linear system along the tree, eliminated leaf first in
+// O(s); the weights are then updated from the new lengths. The length is
+// convex in the Steiner points, so this converges to the global minimum of
+// the topology. Nodes below n are terminals, the s = (edgeCount - 1) / 2
+// nodes from n on are Steiner points, written to steiner[]. With resume the
+// iteration continues from the positions already in steiner[].
+inline double embedTopology(const Vector2<double> *points, std::size_t n, const TopologyEdge *edges, std::size_t edgeCount,
+	Vector2<double> *steiner, int maxIterations = 200, double tolerance = 1e-7, bool resume = false)
+{
+	const std::size_t maxSteiner = topologyMaxTerminals - 2, maxEdges = 2 * topologyMaxTerminals - 3;
+	const std::size_t s = (edgeCount - 1) / 2;
+
+	// Edges of every Steiner point
+	uint8_t incident[maxSteiner][3], degree[maxSteiner] = { 0 };
+	for (std::size_t e = 0; e < edgeCount; e++)
+		for (int k = 0; k < 2; k++)
+			if (edges[e][k] >= n) { std::size_t i = edges[e][k] - n; incident[i][degree[i]++] = (uint8_t)e; }
+
+	// Breadth-first order over the Steiner points, with the edge to the parent
+	uint8_t order[maxSteiner], parent[maxSteiner], up[maxSteiner];
+	bool seen[maxSteiner] = { false };
+	std::size_t count = 1;
+	order[0] = 0; seen[0] = true; parent[0] = up[0] = 0xff;
+	for (std::size_t q = 0; q < count; q++)
+	{
+		std::size_t i = order[q];
+		for (int k = 0; k < degree[i]; k++)
+		{
+			const TopologyEdge &e = edges[incident[i][k]];
+			std::size_t other = e[0] == i + n ? e[1] : e[0];
+			if (other < n || seen[other - n]) continue;
+			seen[other - n] = true;
+			parent[other - n] = (uint8_t)i;
+			up[other - n] = incident[i][k];
+			order[count++] = (uint8_t)(other - n);
+		}
+	}
+
+	// Smallest length that still gives a finite weight
+	double lo = DBL_MAX, hi = -DBL_MAX;
+	for (std::size_t i = 0; i < n; i++) { lo = std::min(lo, std::min(points[i].x, points[i].y)); hi = std::max(hi, std::max(points[i].x, points[i].y)); }
+	const double floor = std::max(hi - lo, 1e-300) * 1e-12;
+
+	double weight[maxEdges], a[maxSteiner], bx[maxSteiner], by[maxSteiner];
+	auto position = [&](std::size_t node) -> const Vector2<double>& { return node < n ? points[node] : steiner[node - n]; };
+
+	for (std::size_t e = 0; e < edgeCount; e++)
+	{
+		weight[e] = 1;
+		if (!resume) continue;
+		const Vector2<double> &p = position(edges[e][0]), &q = position(edges[e][1]);
+		weight[e] = 1 / std::max(sqrt((p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y)), floor);
+	}
+
+	double length = DBL_MAX;
+	for (int iteration = 0; iteration < maxIterations; iteration++)
+	{
+		for (std::size_t i = 0; i < s; i++)
+		{
+			a[i] = bx[i] = by[i] = 0;
+			for (int k = 0; k < degree[i]; k++)
+			{
+				const TopologyEdge &e = edges[incident[i][k]];
+				double w = weight[incident[i][k]];
+				std::size_t other = e[0] == i + n ? e[1] : e[0];
+				a[i] += w;
+				if (other < n) { bx[i] += w * points[other].x; by[i] += w * points[other].y; }
+			}
+		}
+
+		// Leaves first into their parents, then back from the root
+		for (std::size_t q = s; q-- > 1;)
+		{
+			std::size_t i = order[q], p = parent[i];
+			double w = weight[up[i]], f = w / a[i];
+			a[p] -= w * f;
+			bx[p] += f * bx[i];
+			by[p] += f * by[i];
+		}
+		for (std::size_t q = 0; q < s; q++)
+		{
+			std::size_t i = order[q];
+			double x = bx[i], y = by[i];
+			if (q > 0) { double w = weight[up[i]]; x += w * steiner[parent[i]].x; y += w * steiner[parent[i]].y; }
+			steiner[i] = Vector2<double>(x / a[i], y / a[i]);
+		}
+
+		double previous = length;
+		length = 0;
+		for (std::size_t e = 0; e < edgeCount; e++)
+		{
+			const Vector2<double> &p = position(edges[e][0]), &q = position(edges[e][1]);
+			double d = sqrt((p.x - q.x) * (p.x - q.x) + (p.y - q.y) * (p.y - q.y));
+			length += d;
+			weight[e] = 1 / std::max(d, floor);
+		}
+
+		if (previous - length <= tolerance * length) break;
+	}
+
+	return length;
+}
+
+// Exact Steiner minimal tree of a small net by Smith's branch and bound: the
+// terminals are added one at a time, each into every edge of the topology
+// of the ones before it. Adding a terminal never makes the shortest
+// embedding shorter, so a partial topology already longer than the best
+// full one is cut with all its descendants. Only for the table generator
+// and for checks, the search is exponential in n.
+class TopologySearch
+{
+public:
+	// Length of the best tree; its edges (2n - 3) are written to best
+	double solve(const Vector2<double> *points, std::size_t n, TopologyEdge *best)
+	{
+		_points = points;
+		_n = n;
+		_best = best;
+
+		// Insertion order: each next terminal the farthest from the ones placed
+		std::size_t a = 0, b = 1;
+		for (std::size_t i = 0; i < n; i++)
+			for (std::size_t j = i + 1; j < n; j++)
+				if (distance(i, j) > distance(a, b)) a = i, b = j;
+
+		double nearest[topologyMaxTerminals];
+		bool placed[topologyMaxTerminals] = { false };
+		_order[0] = (uint8_t)a; _order[1] = (uint8_t)b;
+		placed[a] = placed[b] = true;
+		for (std::size_t i = 0; i < n; i++) nearest[i] = std::min(distance(i, a), distance(i, b));
+		for (std::size_t k = 2; k < n; k++)
+		{
+			std::size_t far = n;
+			for (std::size_t i = 0; i < n; i++)
+				if (!placed[i] && (far == n || nearest[i] > nearest[far])) far = i;
+			_order[k] = (uint8_t)far;
+			placed[far] = true;
+			for (std::size_t i = 0; i < n; i++) nearest[i] = std::min(nearest[i], distance(i, far));
+		}
+
+		// The MST bounds the answer from above; the slack lets a tree that
+		// degenerates into the MST, reached only in the limit, still count
+		_bound = mstLength() * (1 + 1e-3);
+		_found = false;
+
+		_edges[0][0] = _order[0]; _edges[0][1] = (uint8_t)n;
+		_edges[1][0] = _order[1]; _edges[1][1] = (uint8_t)n;
+		_edges[2][0] = _order[2]; _edges[2][1] = (uint8_t)n;
+		search(3);
+
+		return _found ? _bound : -1;
+	}
+
+private:
+	double distance(std::size_t i, std::size_t j) const
+	{
+		double dx = _points[i].x - _points[j].x, dy = _points[i].y - _points[j].y;
+		return sqrt(dx * dx + dy * dy);
+	}
+
+	double mstLength() const
+	{
+		double key[topologyMaxTerminals];
+		bool in[topologyMaxTerminals] = { false };
+		for (std::size_t i = 0; i < _n; i++) key[i] = DBL_MAX;
+		key[0] = 0;
+
+		double length = 0;
+		for (std::size_t k = 0; k < _n; k++)
+		{
+			std::size_t u = _n;
+			for (std::size_t i = 0; i < _n; i++)
+				if (!in[i] && (u == _n || key[i] < key[u])) u = i;
+			in[u] = true;
+			length += key[u];
+			for (std::size_t i = 0; i < _n; i++)
+				if (!in[i]) key[i] = std::min(key[i], distance(u, i));
+		}
+		return length;
+	}
+
+	// _edges holds the topology of the first k terminals of _order
+	void search(std::size_t k)
+	{
+		const std::size_t edgeCount = 2 * k - 3;
+		Vector2<double> steiner[topologyMaxTerminals - 2];
+
+		if (k == _n)
+		{
+			double length = embedTopology(_points, _n, _edges, edgeCount, steiner, 1000, 1e-10);
+			if (length < _bound)
+			{
+				_bound = length;
+				_found = true;
+				memcpy(_best, _edges, edgeCount * sizeof(TopologyEdge));
+			}
+			return;
+		}
+
+		// Every edge the next terminal can split, shortest partial tree first
+		struct Child { double length; std::size_t edge; } children[2 * topologyMaxTerminals - 3];
+		for (std::size_t e = 0; e < edgeCount; e++)
+		{
+			split(k, e);
+			children[e].length = embedTopology(_points, _n, _edges, edgeCount + 2, steiner, 1000, 1e-10);
+			children[e].edge = e;
+			unsplit(k, e);
+		}
+		std::sort(children, children + edgeCount, [](const Child &a, const Child &b) { return a.length < b.length; });
+
+		for (std::size_t c = 0; c < edgeCount; c++)
+		{
+			// Slack for the iteration stopping a little above the minimum
+			if (children[c].length >= _bound * (1 + 1e-7)) break;
+			split(k, children[c].edge);
+			search(k + 1);
+			unsplit(k, children[c].edge);
+		}
+	}
+
+	// Steiner point n + k - 2 on edge e, joined to terminal _order[k]
+	void split(std::size_t k, std::size_t e)
+	{
+		const std::size_t edgeCount = 2 * k - 3;
+		uint8_t s = (uint8_t)(_n + k - 2);
+		_edges[edgeCount][0] = _edges[e][1]; _edges[edgeCount][1] = s;
+		_edges[edgeCount + 1][0] = _order[k]; _edges[edgeCount + 1][1] = s;
+		_edges[e][1] = s;
+	}
+
+	void unsplit(std::size_t k, std::size_t e)
+	{
+		_edges[e][1] = _edges[2 * k - 3][0];
+	}
+
+	const Vector2<double> *_points;
+	std::size_t _n;
+	TopologyEdge *_best;
+	TopologyEdge _edges[2 * topologyMaxTerminals - 3];
+	uint8_t _order[topologyMaxTerminals];
+	double _bound;
+	bool _found;
+};
+
+// Binary topology table: this header, then for every terminal count from
+// minTerminals to maxTerminals a TopologyLevelHeader, the distinct
+// topologies (2n - 3 edges of two bytes each, terminals in canonical
+// order), n! + 1 uint32 offsets and the uint16 candidate lists they delimit,
+// one list per order class, most frequently optimal topology first.
+struct TopologyTableHeader
+{
+	char magic[4];			// "SMTT"
+	uint32_t version;
+	uint32_t minTerminals;
+	uint32_t maxTerminals;
+};
+
+struct TopologyLevelHeader
+{
+	uint32_t terminals;
+	uint32_t topologies;
+	uint32_t classes;		// n!
+	uint32_t candidates;
+};
+
+static const uint32_t topologyTableVersion = 1;
+
+class TopologyTable
+{
+public:
+	struct Level
+	{
+		std::vector<TopologyEdge> edges;	// topologies * (2n - 3)
+		std::vector<uint32_t> offsets;		// classes + 1
+		std::vector<uint16_t> candidates;
+	};
+
+	void load(const char *path)
+	{
+		FILE *file = fopen(path, "rb");
+		if (!file) throw "Cant open file / Wrong way";
+
+		fseek(file, 0, SEEK_END);
+		const long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		TopologyTableHeader header;
+		bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, "SMTT", 4) == 0;
+		if (!ok || header.version != topologyTableVersion)
+		{
+			fclose(file);
+			throw "Not a topology table";
+		}
+
+		ok = header.minTerminals >= topologyMinTerminals && header.maxTerminals <= topologyMaxTerminals && header.minTerminals <= header.maxTerminals;
+		_min = header.minTerminals;
+		_levels.assign(ok ? header.maxTerminals - header.minTerminals + 1 : 0, Level());
+
+		for (std::size_t n = _min; ok && n < _min + _levels.size(); n++)
+		{
+			TopologyLevelHeader level;
+			Level &l = _levels[n - _min];
+			ok = fread(&level, sizeof(level), 1, file) == 1 && level.terminals == n && level.classes == factorial(n)
+				&& level.topologies <= std::min<uint32_t>(fullTopologies(n), 0xffff)
+				&& (uint64_t)level.candidates <= (uint64_t)level.classes * level.topologies;
+			if (!ok) break;
+
+			// The counts come from the file: nothing is allocated for more
+			// than the rest of it holds
+			const long position = ftell(file);
+			const uint64_t bytes = (uint64_t)level.topologies * (2 * n - 3) * sizeof(TopologyEdge)
+				+ ((uint64_t)level.classes + 1) * sizeof(uint32_t) + (uint64_t)level.candidates * sizeof(uint16_t);
+			ok = size >= 0 && position >= 0 && bytes <= (uint64_t)(size - position);
+			if (!ok) break;
+
+			l.edges.resize((std::size_t)level.topologies * (2 * n - 3));
+			l.offsets.resize((std::size_t)level.classes + 1);
+			l.candidates.resize(level.candidates);
+			ok = fread(l.edges.data(), sizeof(TopologyEdge), l.edges.size(), file) == l.edges.size()
+				&& fread(l.offsets.data(), sizeof(uint32_t), l.offsets.size(), file) == l.offsets.size()
+				&& fread(l.candidates.data(), sizeof(uint16_t), l.candidates.size(), file) == l.candidates.size();
+
+			// Everything the lookups index with
+			ok = ok && l.offsets.front() == 0 && l.offsets.back() == level.candidates;
+			for (std::size_t c = 0; ok && c < level.classes; c++) ok = l.offsets[c] <= l.offsets[c + 1];
+			for (std::size_t c = 0; ok && c < l.candidates.size(); c++) ok = l.candidates[c] < level.topologies;
+			for (std::size_t e = 0; ok && e < l.edges.size(); e++) ok = l.edges[e][0] < 2 * n - 2 && l.edges[e][1] < 2 * n - 2;
+
+			// Leaves at the terminals, degree 3 at the Steiner points, and a
+			// tree: 2n - 3 edges joining 2n - 2 nodes without a cycle
+			for (std::size_t t = 0; ok && t < level.topologies; t++)
+			{
+				uint8_t degree[2 * topologyMaxTerminals - 2] = { 0 }, root[2 * topologyMaxTerminals - 2];
+				for (std::size_t i = 0; i < 2 * n - 2; i++) root[i] = (uint8_t)i;
+				for (std::size_t e = t * (2 * n - 3); ok && e < (t + 1) * (2 * n - 3); e++)
+				{
+					uint8_t a = l.edges[e][0], b = l.edges[e][1];
+					degree[a]++;
+					degree[b]++;
+					while (root[a] != a) a = root[a];
+					while (root[b] != b) b = root[b];
+					ok = a != b;
+					root[a] = b;
+				}
+				for (std::size_t i = 0; ok && i < 2 * n - 2; i++) ok = degree[i] == (i < n ? 1 : 3);
+			}
+		}
+
+		fclose(file);
+		if (!ok)
+		{
+			_levels.clear();
+			throw "Corrupt topology table";
+		}
+	}
+
+	void save(const char *path) const
+	{
+		FILE *file = fopen(path, "wb");
+		if (!file) throw "Cant open file / Wrong way";
+
+		TopologyTableHeader header;
+		memcpy(header.magic, "SMTT", 4);
+		header.version = topologyTableVersion;
+		header.minTerminals = (uint32_t)_min;
+		header.maxTerminals = (uint32_t)(_min + _levels.size() - 1);
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+
+		for (std::size_t n = _min; ok && n < _min + _levels.size(); n++)
+		{
+			const Level &l = _levels[n - _min];
+			TopologyLevelHeader level;
+			level.terminals = (uint32_t)n;
+			level.topologies = (uint32_t)(l.edges.size() / (2 * n - 3));
+			level.classes = (uint32_t)(l.offsets.size() - 1);
+			level.candidates = (uint32_t)l.candidates.size();
+
+			ok = fwrite(&level, sizeof(level), 1, file) == 1
+				&& fwrite(l.edges.data(), sizeof(TopologyEdge), l.edges.size(), file) == l.edges.size()
+				&& fwrite(l.offsets.data(), sizeof(uint32_t), l.offsets.size(), file) == l.offsets.size()
+				&& fwrite(l.candidates.data(), sizeof(uint16_t), l.candidates.size(), file) == l.candidates.size();
+		}
+
+		if (fclose(file) != 0 || !ok) throw "Cant write file";
+	}
+
+	// For the generator: levels minTerminals..maxTerminals, empty
+	void reset(std::size_t minTerminals, std::size_t maxTerminals)
+	{
+		_min = minTerminals;
+		_levels.assign(maxTerminals - minTerminals + 1, Level());
+	}
+
+	Level& level(std::size_t n) { return _levels[n - _min]; }
+
+	bool covers(std::size_t n) const { return n >= _min && n < _min + _levels.size(); }
+	std::size_t getMinTerminals() const { return _min; }
+	std::size_t getMaxTerminals() const { return _min + _levels.size() - 1; }
+
+	// Candidate topologies of an order class, as [first, last) of ids
+	const uint16_t* candidates(std::size_t n, uint32_t index, std::size_t &count) const
+	{
+		const Level &l = _levels[n - _min];
+		count = l.offsets[index + 1] - l.offsets[index];
+		return l.candidates.data() + l.offsets[index];
+	}
+
+	const TopologyEdge* topology(std::size_t n, uint16_t id) const
+	{
+		return _levels[n - _min].edges.data() + (std::size_t)id * (2 * n - 3);
+	}
+
+private:
+	std::vector<Level> _levels;
+	std::size_t _min = topologyMinTerminals;
+};
+
+// Fast path for nets of a few terminals: the net is brought into canonical
+// order, its order class picks the candidate topologies from the table and
+// only their embeddings are computed, no triangulation or candidate search.
+// The shortest of them (or the MST, if no candidate beats it) is returned;
+// Steiner points that collapsed onto a neighbour are merged into it.
+template <class T>
+class SmallNetSteiner
+{
+public:
+	using VertexType = Vector2<T>;
+
+	// Nets of more than maxTerminals terminals are left to the caller
+	void setTable(const TopologyTable *table, std::size_t maxTerminals = topologyMaxTerminals)
+	{
+		_table = table;
+		_maxTerminals = maxTerminals;
+	}
+	bool accepts(std::size_t count) const { return _table && count <= _maxTerminals && _table->covers(count); }
+
+	// False when the net is not covered by the table
+	bool solve(const VertexType *points, std::size_t count, SteinerSolution<T> &result)
+	{
+		if (!accepts(count)) return false;
+		const std::size_t n = count;
+
+		uint8_t order[topologyMaxTerminals];
+		uint32_t index = orderClass(points, n, order);
+
+		// Canonical order, relative to the first terminal
+		Vector2<double> local[topologyMaxTerminals];
+		const double ox = (double)points[order[0]].x, oy = (double)points[order[0]].y;
+		for (std::size_t i = 0; i < n; i++)
+			local[i] = Vector2<double>((double)points[order[i]].x - ox, (double)points[order[i]].y - oy);
+
+		std::size_t candidates;
+		const uint16_t *ids = _table->candidates(n, index, candidates);
+		const std::size_t s = n - 2;
+		_rough.resize(candidates);
+		_steiner.resize(candidates * s);
+
+		// Every candidate roughly, the ones close to the best to full precision
+		double roughest = DBL_MAX;
+		for (std::size_t c = 0; c < candidates; c++)
+		{
+			_rough[c] = embedTopology(local, n, _table->topology(n, ids[c]), 2 * n - 3, &_steiner[c * s], roughIterations, roughTolerance);
+			roughest = std::min(roughest, _rough[c]);
+		}
+
+		const TopologyEdge *best = nullptr;
+		const Vector2<double> *bestSteiner = nullptr;
+		double bestLength = mst(local, n);
+		for (std::size_t c = 0; c < candidates; c++)
+		{
+			if (_rough[c] > roughest * (1 + refineMargin)) continue;
+			const TopologyEdge *edges = _table->topology(n, ids[c]);
+			double length = embedTopology(local, n, edges, 2 * n - 3, &_steiner[c * s], 200, 1e-7, true);
+			if (length < bestLength)
+			{
+				bestLength = length;
+				best = edges;
+				bestSteiner = &_steiner[c * s];
+			}
+		}
+
+		result.points.assign(points, points + n);
+		result.tree.clear();
+		result.optimal = false;
+
+		if (!best)
+		{
+			// Canonical indices back to the input
+			for (std::size_t i = 1; i < n; i++) result.tree.push_back(IndexEdge(order[i], order[_parent[i]]));
+		}
+		else
+			collapse(local, n, best, bestSteiner, order, ox, oy, result);
+
+		double length = 0;
+		for (auto e = begin(result.tree); e != end(result.tree); e++)
+		{
+			double dx = (double)result.points[e->a].x - result.points[e->b].x, dy = (double)result.points[e->a].y - result.points[e->b].y;
+			length += sqrt(dx * dx + dy * dy);
+		}
+		result.length = (float)length;
+		return true;
+	}
+
+private:
+	// Prim on the complete graph, parents in _parent
+	double mst(const Vector2<double> *points, std::size_t n)
+	{
+		double key[topologyMaxTerminals];
+		bool in[topologyMaxTerminals] = { false };
+		for (std::size_t i = 0; i < n; i++) key[i] = DBL_MAX;
+		key[0] = 0;
+
+		double length = 0;
+		for (std::size_t k = 0; k < n; k++)
+		{
+			std::size_t u = n;
+			for (std::size_t i = 0; i < n; i++)
+				if (!in[i] && (u == n || key[i] < key[u])) u = i;
+			in[u] = true;
+			length += key[u];
+			for (std::size_t i = 0; i < n; i++)
+			{
+				double dx = points[u].x - points[i].x, dy = points[u].y - points[i].y, d = sqrt(dx * dx + dy * dy);
+				if (!in[i] && d < key[i]) { key[i] = d; _parent[i] = (uint8_t)u; }
+			}
+		}
+		return length;
+	}
+
+	// Screening pass, and how far above the best rough length a candidate is still refined
+	static const int roughIterations = 8;
+	static constexpr double roughTolerance = 1e-4;
+	static constexpr double refineMargin = 1e-2;
+
+	// A Steiner point is merged into the neighbour it can move onto without
+	// the tree getting longer, as when the embedding is converging to a
+	// degenerate tree (the point on a terminal or on another Steiner point)
+	void collapse(const Vector2<double> *local, std::size_t n, const TopologyEdge *edges, const Vector2<double> *steiner,
+		const uint8_t *order, double ox, double oy, SteinerSolution<T> &result)
+	{
+		const std::size_t nodes = 2 * n - 2, edgeCount = 2 * n - 3;
+		Vector2<double> position[2 * topologyMaxTerminals - 2];
+		std::copy(local, local + n, position);
+		std::copy(steiner, steiner + n - 2, position + n);
+
+		double extent = 0;
+		for (std::size_t i = 0; i < n; i++) extent = std::max(extent, std::max(fabs(local[i].x), fabs(local[i].y)));
+
+		// Merged nodes point to the node they moved onto
+		uint8_t root[2 * topologyMaxTerminals - 2];
+		for (std::size_t i = 0; i < nodes; i++) root[i] = (uint8_t)i;
+		auto find = [&root](std::size_t i) { while (root[i] != i) i = root[i] = root[root[i]]; return i; };
+		auto distance = [&position](std::size_t a, std::size_t b) {
+			double dx = position[a].x - position[b].x, dy = position[a].y - position[b].y;
+			return sqrt(dx * dx + dy * dy);
+		};
+
+		for (std::size_t i = n; i < nodes; i++)
+		{
+			std::size_t target = nodes;
+			double least = 1e-12 * extent;
+			for (std::size_t e = 0; e < edgeCount; e++)
+			{
+				std::size_t a = find(edges[e][0]), b = find(edges[e][1]);
+				if (a != i && b != i) continue;
+				std::size_t j = a == i ? b : a;
+				if (j == i) continue;
+
+				// Length change with i moved onto j
+				double change = -distance(i, j);
+				for (std::size_t f = 0; f < edgeCount; f++)
+				{
+					std::size_t c = find(edges[f][0]), d = find(edges[f][1]);
+					if (c != i && d != i) continue;
+					std::size_t k = c == i ? d : c;
+					if (k != i && k != j) change += distance(j, k) - distance(i, k);
+				}
+				if (change <= least) { least = change; target = j; }
+			}
+			if (target < nodes) root[i] = (uint8_t)target;
+		}
+
+		// Output index of every remaining node
+		uint32_t index[2 * topologyMaxTerminals - 2];
+		for (std::size_t i = 0; i < n; i++) index[i] = order[i];
+		for (std::size_t i = n; i < nodes; i++)
+		{
+			if (find(i) != i) continue;
+			index[i] = (uint32_t)result.points.size();
+			result.points.push_back(VertexType(toCoordinate<T>(steiner[i - n].x + ox), toCoordinate<T>(steiner[i - n].y + oy)));
+		}
+
+		for (std::size_t e = 0; e < 2 * n - 3; e++)
+		{
+			std::size_t a = find(edges[e][0]), b = find(edges[e][1]);
+			if (a != b) result.tree.push_back(IndexEdge(index[a], index[b]));
+		}
+	}
+
+	const TopologyTable *_table = nullptr;
+	std::size_t _maxTerminals = topologyMaxTerminals;
+	uint8_t _parent[topologyMaxTerminals];
+	std::vector<double> _rough;
+	std::vector<Vector2<double>> _steiner;	// Embedding of every candidate
+};
+
+#endif
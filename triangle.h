@@ -3,6 +3,7 @@
 
 #include "vector2.h"
 #include "edge.h"
+#include "predicates.h"
 
 #include <assert.h>
 #include <math.h>
@@ -27,20 +28,12 @@ class Triangle
 		
 		bool circumCircleContains(const VertexType &v)
 		{
-			float ab = (p1.x * p1.x) + (p1.y * p1.y);
-			float cd = (p2.x * p2.x) + (p2.y * p2.y);
-			float ef = (p3.x * p3.x) + (p3.y * p3.y);
+			// Inclusive test, whatever the orientation of the triangle
+			double o = orient2d(p1, p2, p3);
+			if (o == 0) return false;
 
-			float circum_x = (ab * (p3.y - p2.y) + cd * (p1.y - p3.y) + ef * (p2.y - p1.y)) /
-				(p1.x * (p3.y - p2.y) + p2.x * (p1.y - p3.y) + p3.x * (p2.y - p1.y)) / 2.f;
-			float circum_y = (ab * (p3.x - p2.x) + cd * (p1.x - p3.x) + ef * (p2.x - p1.x)) /
-				(p1.y * (p3.x - p2.x) + p2.y * (p1.x - p3.x) + p3.y * (p2.x - p1.x)) / 2.f;
-			float circum_radius = sqrtf(((p1.x - circum_x) * (p1.x - circum_x))
-				+ ((p1.y - circum_y) * (p1.y - circum_y)));
-
-			float dist = sqrtf(((v.x - circum_x) * (v.x - circum_x))
-				+ ((v.y - circum_y) * (v.y - circum_y)));
-			return dist <= circum_radius;
+			double d = incircle(p1, p2, p3, v);
+			return o > 0 ? d >= 0 : d <= 0;
 		}
 
 		VertexType p1;
@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <cmath>
+#include <limits>
+#include <type_traits>
 
 template <typename T>
 class Vector2
@@ -60,5 +62,23 @@ bool operator == (Vector2<T> v1, Vector2<T> v2)
 {
 	return (v1.x == v2.x) && (v1.y == v2.y);
 }
+
+// Coordinate from a computed value, rounded to the nearest for integer types
+template <typename T>
+inline T toCoordinate(double v)
+{
+	return std::is_integral<T>::value ? (T)std::floor(v + 0.5) : (T)v;
+}
+
+// True when toCoordinate<T>(v) is in range. The bounds are powers of two,
+// exact in double; the maximum is not (2^63 - 1 rounds up), so the upper
+// bound is exclusive.
+template <typename T>
+inline bool fitsCoordinate(double v)
+{
+	if (!std::is_integral<T>::value) return true;
+	double r = std::floor(v + 0.5);
+	return r >= (double)std::numeric_limits<T>::min() && r < -(double)std::numeric_limits<T>::min();
+}
 	
 #endif